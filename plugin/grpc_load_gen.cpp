@@ -0,0 +1,465 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <google/protobuf/descriptor.h>
+#include <google/protobuf/descriptor.pb.h>
+#include <google/protobuf/dynamic_message.h>
+#include <google/protobuf/util/json_util.h>
+#include <grpcpp/generic/generic_stub.h>
+#include <grpcpp/grpcpp.h>
+#include <zlib.h>
+#include "UnrealGrpc/GrpcChannelPool.h"
+#include "UnrealGrpc/GrpcLatencyHistogram.h"
+
+// Drives load against a gRPC server using only a descriptor set, so backend changes can be capacity
+// tested with the same schemas the game uses without compiling any generated code:
+//
+//   protoc --descriptor_set_out=game.pb --include_imports -I protos game.proto
+//   grpc-load-gen --descriptors=game.pb --method=game.PlayerService/GetPlayerProfile
+//                 --target=localhost:50051 --concurrency=64 --rate=5000 --duration=30
+//
+// --compression_report skips the load test and instead measures what deflate and gzip would save
+// and cost on requests and responses synthesized from the method's schema.
+
+using namespace google::protobuf;
+
+static constexpr int kRandomRequestCount = 256;
+static constexpr int kMaxRandomDepth = 4;
+
+struct LoadGenOptions {
+    std::string descriptors;
+    std::string method;
+    std::string target = "localhost:50051";
+    std::string request_template;
+    int concurrency = 16;
+    //requests per second, 0 runs closed loop as fast as the concurrency allows
+    double rate = 0;
+    double duration_seconds = 10;
+    int64_t max_requests = 0;
+    int channels = 1;
+    uint32_t seed = 1;
+    grpc_compression_algorithm compression = GRPC_COMPRESS_NONE;
+    bool compression_report = false;
+};
+
+static void PrintUsage() {
+    fprintf(stderr,
+        "usage: grpc-load-gen --descriptors=<set.pb> --method=<pkg.Service/Method> [options]\n"
+        "  --target=<host:port>        server to load (default localhost:50051)\n"
+        "  --request_template=<file>   JSON request sent on every call instead of random requests\n"
+        "  --concurrency=<n>           maximum outstanding calls (default 16)\n"
+        "  --rate=<qps>                open-loop request rate, 0 for closed loop (default 0)\n"
+        "  --duration=<seconds>        how long to run (default 10)\n"
+        "  --requests=<n>              stop after n requests instead\n"
+        "  --channels=<n>              connections to spread calls across (default 1)\n"
+        "  --seed=<n>                  seed for random requests (default 1)\n"
+        "  --compression=<algorithm>   none, deflate or gzip for every request (default none)\n"
+        "  --compression_report        print compression ratio and cost for the method's messages and exit\n");
+}
+
+static bool ParseArgs(int argc, char* argv[], LoadGenOptions& options) {
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        if (arg.rfind("--", 0) != 0) {
+            fprintf(stderr, "Unrecognised argument: %s\n", arg.c_str());
+            return false;
+        }
+        //flags without a value are switches
+        const size_t eq = arg.find('=');
+        const std::string key = arg.substr(2, eq == std::string::npos ? std::string::npos : eq - 2);
+        const std::string value = eq == std::string::npos ? "true" : arg.substr(eq + 1);
+        if (key == "descriptors") options.descriptors = value;
+        else if (key == "method") options.method = value;
+        else if (key == "target") options.target = value;
+        else if (key == "request_template") options.request_template = value;
+        else if (key == "concurrency" || key == "rate" || key == "duration" || key == "requests" || key == "channels" || key == "seed") {
+            //std::sto* throw on text that isn't a number or doesn't fit, which should print usage rather than abort
+            try {
+                if (key == "concurrency") options.concurrency = std::max(1, std::stoi(value));
+                else if (key == "rate") options.rate = std::stod(value);
+                else if (key == "duration") options.duration_seconds = std::stod(value);
+                else if (key == "requests") options.max_requests = std::stoll(value);
+                else if (key == "channels") options.channels = std::max(1, std::stoi(value));
+                else options.seed = static_cast<uint32_t>(std::stoul(value));
+            }
+            catch (const std::logic_error&) {
+                fprintf(stderr, "Invalid number for --%s: %s\n", key.c_str(), value.c_str());
+                return false;
+            }
+        }
+        else if (key == "compression_report") options.compression_report = value != "false";
+        else if (key == "compression") {
+            if (value == "none") options.compression = GRPC_COMPRESS_NONE;
+            else if (value == "deflate") options.compression = GRPC_COMPRESS_DEFLATE;
+            else if (value == "gzip") options.compression = GRPC_COMPRESS_GZIP;
+            else {
+                fprintf(stderr, "Unknown compression algorithm: %s\n", value.c_str());
+                return false;
+            }
+        }
+        else {
+            fprintf(stderr, "Unknown option: --%s\n", key.c_str());
+            return false;
+        }
+    }
+    if (options.descriptors.empty() || options.method.empty()) return false;
+    return true;
+}
+
+static bool LoadDescriptors(const std::string& path, DescriptorPool& pool) {
+    std::ifstream in(path, std::ios::binary);
+    FileDescriptorSet set;
+    if (!in || !set.ParseFromIstream(&in)) {
+        fprintf(stderr, "Could not read descriptor set %s\n", path.c_str());
+        return false;
+    }
+    //--include_imports writes dependencies before their dependents, so files build in order
+    for (const FileDescriptorProto& file : set.file()) {
+        if (pool.BuildFile(file) == nullptr) {
+            fprintf(stderr, "Could not build %s from the descriptor set\n", std::string(file.name()).c_str());
+            return false;
+        }
+    }
+    return true;
+}
+
+static void FillRandomField(Message& msg, const FieldDescriptor* field, std::mt19937& rng, int depth);
+
+//fills every field with plausible random data so payload sizes resemble real traffic
+static void FillRandomMessage(Message& msg, std::mt19937& rng, int depth) {
+    const Descriptor* desc = msg.GetDescriptor();
+    for (int i = 0; i < desc->field_count(); i++) {
+        const FieldDescriptor* field = desc->field(i);
+        //only fill one member of each oneof
+        if (field->real_containing_oneof() != nullptr && field->index_in_oneof() != 0) continue;
+        if (field->is_repeated()) {
+            const int count = std::uniform_int_distribution<int>(0, 4)(rng);
+            for (int j = 0; j < count; j++) FillRandomField(msg, field, rng, depth);
+        } else {
+            FillRandomField(msg, field, rng, depth);
+        }
+    }
+}
+
+static void FillRandomField(Message& msg, const FieldDescriptor* field, std::mt19937& rng, int depth) {
+    const Reflection* refl = msg.GetReflection();
+    const bool repeated = field->is_repeated();
+    const auto rand_int = [&rng](int64_t lo, int64_t hi) { return std::uniform_int_distribution<int64_t>(lo, hi)(rng); };
+    switch (field->cpp_type()) {
+        case FieldDescriptor::CPPTYPE_INT32: {
+            const auto v = static_cast<int32_t>(rand_int(-1000, 100000));
+            repeated ? refl->AddInt32(&msg, field, v) : refl->SetInt32(&msg, field, v);
+            break;
+        }
+        case FieldDescriptor::CPPTYPE_INT64: {
+            const int64_t v = rand_int(-1000, 1LL << 40);
+            repeated ? refl->AddInt64(&msg, field, v) : refl->SetInt64(&msg, field, v);
+            break;
+        }
+        case FieldDescriptor::CPPTYPE_UINT32: {
+            const auto v = static_cast<uint32_t>(rand_int(0, 100000));
+            repeated ? refl->AddUInt32(&msg, field, v) : refl->SetUInt32(&msg, field, v);
+            break;
+        }
+        case FieldDescriptor::CPPTYPE_UINT64: {
+            const auto v = static_cast<uint64_t>(rand_int(0, 1LL << 40));
+            repeated ? refl->AddUInt64(&msg, field, v) : refl->SetUInt64(&msg, field, v);
+            break;
+        }
+        case FieldDescriptor::CPPTYPE_FLOAT: {
+            const float v = std::uniform_real_distribution<float>(-1000.f, 1000.f)(rng);
+            repeated ? refl->AddFloat(&msg, field, v) : refl->SetFloat(&msg, field, v);
+            break;
+        }
+        case FieldDescriptor::CPPTYPE_DOUBLE: {
+            const double v = std::uniform_real_distribution<double>(-1000.0, 1000.0)(rng);
+            repeated ? refl->AddDouble(&msg, field, v) : refl->SetDouble(&msg, field, v);
+            break;
+        }
+        case FieldDescriptor::CPPTYPE_BOOL: {
+            const bool v = rand_int(0, 1) == 1;
+            repeated ? refl->AddBool(&msg, field, v) : refl->SetBool(&msg, field, v);
+            break;
+        }
+        case FieldDescriptor::CPPTYPE_ENUM: {
+            const EnumDescriptor* enum_desc = field->enum_type();
+            const EnumValueDescriptor* v = enum_desc->value(static_cast<int>(rand_int(0, enum_desc->value_count() - 1)));
+            repeated ? refl->AddEnum(&msg, field, v) : refl->SetEnum(&msg, field, v);
+            break;
+        }
+        case FieldDescriptor::CPPTYPE_STRING: {
+            std::string v(static_cast<size_t>(rand_int(1, 32)), ' ');
+            for (char& c : v) c = static_cast<char>('a' + rand_int(0, 25));
+            repeated ? refl->AddString(&msg, field, v) : refl->SetString(&msg, field, v);
+            break;
+        }
+        case FieldDescriptor::CPPTYPE_MESSAGE: {
+            //recursive schemas would otherwise never terminate
+            if (depth >= kMaxRandomDepth) break;
+            Message* child = repeated ? refl->AddMessage(&msg, field) : refl->MutableMessage(&msg, field);
+            FillRandomMessage(*child, rng, depth + 1);
+            break;
+        }
+    }
+}
+
+static std::vector<std::string> BuildRandomPayloads(const Descriptor* desc, uint32_t seed) {
+    DynamicMessageFactory factory;
+    const Message* prototype = factory.GetPrototype(desc);
+    std::vector<std::string> out;
+    std::mt19937 rng(seed);
+    for (int i = 0; i < kRandomRequestCount; i++) {
+        std::unique_ptr<Message> msg(prototype->New());
+        FillRandomMessage(*msg, rng, 0);
+        out.push_back(msg->SerializeAsString());
+    }
+    return out;
+}
+
+static bool BuildRequests(const LoadGenOptions& options, const Descriptor* input, std::vector<std::string>& out) {
+    if (options.request_template.empty()) {
+        out = BuildRandomPayloads(input, options.seed);
+        return true;
+    }
+    DynamicMessageFactory factory;
+    std::ifstream in(options.request_template);
+    std::stringstream json;
+    json << in.rdbuf();
+    std::unique_ptr<Message> msg(factory.GetPrototype(input)->New());
+    if (!in || !util::JsonStringToMessage(json.str(), msg.get()).ok()) {
+        fprintf(stderr, "Could not parse %s as a %s\n", options.request_template.c_str(), std::string(input->full_name()).c_str());
+        return false;
+    }
+    out.push_back(msg->SerializeAsString());
+    return true;
+}
+
+//compresses the way gRPC's message compression does: zlib at the default level, gzip framing for gzip
+static std::string Compress(const std::string& input, bool gzip) {
+    z_stream stream{};
+    deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 | (gzip ? 16 : 0), 8, Z_DEFAULT_STRATEGY);
+    std::string out(deflateBound(&stream, static_cast<uLong>(input.size())) + 32, '\0');
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input.data()));
+    stream.avail_in = static_cast<uInt>(input.size());
+    stream.next_out = reinterpret_cast<Bytef*>(out.data());
+    stream.avail_out = static_cast<uInt>(out.size());
+    deflate(&stream, Z_FINISH);
+    out.resize(stream.total_out);
+    deflateEnd(&stream);
+    return out;
+}
+
+static void Decompress(const std::string& input, size_t raw_size, bool gzip, std::string& out) {
+    z_stream stream{};
+    inflateInit2(&stream, 15 | (gzip ? 16 : 0));
+    out.resize(raw_size);
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input.data()));
+    stream.avail_in = static_cast<uInt>(input.size());
+    stream.next_out = reinterpret_cast<Bytef*>(out.data());
+    stream.avail_out = static_cast<uInt>(out.size());
+    inflate(&stream, Z_FINISH);
+    inflateEnd(&stream);
+}
+
+static void PrintCompressionReport(const char* label, const std::string& type_name, const std::vector<std::string>& payloads) {
+    size_t raw_bytes = 0;
+    for (const std::string& payload : payloads) raw_bytes += payload.size();
+    printf("%s %s: %zu messages, %.1f bytes on average\n", label, type_name.c_str(), payloads.size(),
+        static_cast<double>(raw_bytes) / static_cast<double>(payloads.size()));
+    for (const bool gzip : {false, true}) {
+        size_t compressed_bytes = 0;
+        std::string scratch;
+        const auto start = std::chrono::steady_clock::now();
+        std::vector<std::string> compressed;
+        for (const std::string& payload : payloads) compressed.push_back(Compress(payload, gzip));
+        const auto compressed_at = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < payloads.size(); i++) Decompress(compressed[i], payloads[i].size(), gzip, scratch);
+        const auto end = std::chrono::steady_clock::now();
+        for (const std::string& payload : compressed) compressed_bytes += payload.size();
+        const auto per_message_us = [&payloads](auto duration) { return std::chrono::duration<double, std::micro>(duration).count() / static_cast<double>(payloads.size()); };
+        printf("  %-8s %6.1f%% of original, compress %.2fus, decompress %.2fus per message\n", gzip ? "gzip" : "deflate",
+            raw_bytes ? 100.0 * static_cast<double>(compressed_bytes) / static_cast<double>(raw_bytes) : 0.0,
+            per_message_us(compressed_at - start), per_message_us(end - compressed_at));
+    }
+}
+
+class LoadRunner {
+public:
+    LoadRunner(const LoadGenOptions& in_options, std::string in_method_path, std::vector<grpc::ByteBuffer> in_requests)
+        : options(in_options), method_path(std::move(in_method_path)), requests(std::move(in_requests)) {
+        UnrealGrpc::FChannelPoolConfig config;
+        config.NumChannels = options.channels;
+        pool = std::make_unique<UnrealGrpc::FChannelPool>(options.target, config);
+        for (int i = 0; i < pool->Num(); i++) stubs.push_back(std::make_unique<grpc::GenericStub>(pool->GetChannel(i)));
+    }
+
+    void Run() {
+        start = std::chrono::steady_clock::now();
+        deadline = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(options.duration_seconds));
+        if (options.rate > 0) RunOpenLoop();
+        else RunClosedLoop();
+        std::unique_lock lock(mutex);
+        idle.wait(lock, [this] { return outstanding == 0; });
+        elapsed = std::chrono::steady_clock::now() - start;
+    }
+
+    void Report() const {
+        const double seconds = std::chrono::duration<double>(elapsed).count();
+        const auto us = [](uint64_t nanos) { return static_cast<double>(nanos) / 1000.0; };
+        printf("method:     %s\n", method_path.c_str());
+        printf("target:     %s (%d channel%s)\n", options.target.c_str(), options.channels, options.channels == 1 ? "" : "s");
+        printf("requests:   %llu ok, %llu failed in %.2fs\n", static_cast<unsigned long long>(histogram.GetCount()),
+            static_cast<unsigned long long>(failed), seconds);
+        printf("throughput: %.1f req/s\n", seconds > 0 ? static_cast<double>(histogram.GetCount()) / seconds : 0.0);
+        printf("latency:    p50 %.1fus  p99 %.1fus  p999 %.1fus  max %.1fus\n",
+            us(histogram.GetPercentile(50)), us(histogram.GetPercentile(99)), us(histogram.GetPercentile(99.9)), us(histogram.GetMax()));
+        for (const auto& [code, count] : failures_by_code) printf("  status %d: %llu\n", code, static_cast<unsigned long long>(count));
+    }
+
+    [[nodiscard]] uint64_t GetFailed() const { return failed; }
+
+private:
+    struct Call {
+        grpc::ClientContext context;
+        grpc::ByteBuffer response;
+        UnrealGrpc::FChannelPool::FLease lease;
+        std::chrono::steady_clock::time_point scheduled;
+    };
+
+    bool ShouldStop(int64_t issued) const {
+        if (options.max_requests > 0) return issued >= options.max_requests;
+        return std::chrono::steady_clock::now() >= deadline;
+    }
+
+    //each completion immediately issues the next call, keeping exactly `concurrency` calls in flight
+    void RunClosedLoop() {
+        for (int i = 0; i < options.concurrency; i++) {
+            if (!TryIssue(std::chrono::steady_clock::now())) break;
+        }
+    }
+
+    //issues on a fixed schedule and measures from the scheduled time, so a slow server can't hide
+    //latency by holding back the next send (coordinated omission)
+    void RunOpenLoop() {
+        const auto interval = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(1.0 / options.rate));
+        for (int64_t i = 0;; i++) {
+            const auto scheduled = start + interval * i;
+            std::this_thread::sleep_until(scheduled);
+            {
+                std::unique_lock lock(mutex);
+                idle.wait(lock, [this] { return outstanding < options.concurrency; });
+            }
+            if (!TryIssue(scheduled)) break;
+        }
+    }
+
+    bool TryIssue(std::chrono::steady_clock::time_point scheduled) {
+        const int64_t index = issued.fetch_add(1);
+        if (ShouldStop(index)) return false;
+        {
+            std::lock_guard lock(mutex);
+            outstanding++;
+        }
+        auto* call = new Call();
+        call->context.set_compression_algorithm(options.compression);
+        call->lease = pool->Acquire();
+        call->scheduled = scheduled;
+        const grpc::ByteBuffer& request = requests[static_cast<size_t>(index) % requests.size()];
+        stubs[call->lease.GetIndex()]->UnaryCall(&call->context, method_path, grpc::StubOptions(), &request, &call->response,
+            [this, call](const grpc::Status& status) { OnDone(call, status); });
+        return true;
+    }
+
+    void OnDone(Call* call, const grpc::Status& status) {
+        const auto nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - call->scheduled).count();
+        delete call;
+        //issue the replacement before retiring this call so Run never sees a momentary zero
+        if (options.rate <= 0) TryIssue(std::chrono::steady_clock::now());
+        {
+            std::lock_guard lock(mutex);
+            if (status.ok()) histogram.Record(static_cast<uint64_t>(nanos));
+            else {
+                failed++;
+                failures_by_code[status.error_code()]++;
+            }
+            outstanding--;
+            //notify under the lock: once outstanding hits zero, Run may return and destroy this runner, idle included
+            idle.notify_all();
+        }
+    }
+
+    const LoadGenOptions& options;
+    const std::string method_path;
+    const std::vector<grpc::ByteBuffer> requests;
+    std::unique_ptr<UnrealGrpc::FChannelPool> pool;
+    std::vector<std::unique_ptr<grpc::GenericStub>> stubs;
+
+    std::chrono::steady_clock::time_point start;
+    std::chrono::steady_clock::time_point deadline;
+    std::chrono::steady_clock::duration elapsed{};
+    std::atomic<int64_t> issued{0};
+
+    std::mutex mutex;
+    std::condition_variable idle;
+    int outstanding = 0;
+    UnrealGrpc::FLatencyHistogram histogram;
+    uint64_t failed = 0;
+    std::map<int, uint64_t> failures_by_code;
+};
+
+int main(int argc, char* argv[]) {
+    LoadGenOptions options;
+    if (!ParseArgs(argc, argv, options)) {
+        PrintUsage();
+        return 2;
+    }
+
+    DescriptorPool pool;
+    if (!LoadDescriptors(options.descriptors, pool)) return 1;
+
+    //accept both the wire path (pkg.Service/Method) and the full name (pkg.Service.Method)
+    std::string method_name = options.method;
+    if (!method_name.empty() && method_name[0] == '/') method_name.erase(0, 1);
+    std::ranges::replace(method_name, '/', '.');
+    const MethodDescriptor* method = pool.FindMethodByName(method_name);
+    if (method == nullptr) {
+        fprintf(stderr, "Method %s is not in %s\n", options.method.c_str(), options.descriptors.c_str());
+        return 1;
+    }
+    std::vector<std::string> payloads;
+    if (!BuildRequests(options, method->input_type(), payloads)) return 1;
+
+    if (options.compression_report) {
+        PrintCompressionReport("request", std::string(method->input_type()->full_name()), payloads);
+        PrintCompressionReport("response", std::string(method->output_type()->full_name()), BuildRandomPayloads(method->output_type(), options.seed));
+        return 0;
+    }
+
+    if (method->client_streaming() || method->server_streaming()) {
+        fprintf(stderr, "Only unary methods can be load tested, %s is streaming\n", std::string(method->full_name()).c_str());
+        return 1;
+    }
+
+    std::vector<grpc::ByteBuffer> requests;
+    for (const std::string& payload : payloads) {
+        grpc::Slice slice(payload);
+        requests.emplace_back(&slice, 1);
+    }
+
+    LoadRunner runner(options, "/" + std::string(method->service()->full_name()) + "/" + std::string(method->name()), std::move(requests));
+    runner.Run();
+    runner.Report();
+    return runner.GetFailed() == 0 ? 0 : 1;
+}
@@ -0,0 +1,181 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <grpcpp/generic/generic_stub.h>
+#include <grpcpp/grpcpp.h>
+#include "UnrealGrpc/GrpcChannelPool.h"
+#include "UnrealGrpc/GrpcLatencyHistogram.h"
+#include "UnrealGrpc/GrpcLoopback.h"
+#include "UnrealGrpc/GrpcTrafficRecorder.h"
+
+// Replays a recording made with UnrealGrpc::FTrafficRecorder against a server, at the recorded pace
+// or faster, so a production load profile can be rerun against a new server build:
+//
+//   grpc-replay --recording=Saved/Match.rec --target=localhost:50051 --speed=4
+//
+// Requests go out as the recorded bytes, so no schemas are needed. --summary only describes the
+// recording. To run a recording through the generated converters instead, use the generated
+// Replay<Service>Recording.
+
+struct ReplayOptions {
+    std::string recording;
+    std::string target = "localhost:50051";
+    //only replay this method path, e.g. /game.PlayerService/GetPlayerProfile
+    std::string method;
+    double speed = 1.0;
+    int channels = 1;
+    bool summary = false;
+};
+
+static void PrintUsage() {
+    fprintf(stderr,
+        "usage: grpc-replay --recording=<file> [options]\n"
+        "  --target=<host:port>        server to replay against (default localhost:50051)\n"
+        "  --speed=<factor>            1 replays at the recorded pace, 4 four times as fast, 0 as fast as possible (default 1)\n"
+        "  --method=</pkg.Service/M>   only replay calls to this method\n"
+        "  --channels=<n>              connections to spread calls across (default 1)\n"
+        "  --summary                   print what the recording holds and exit\n");
+}
+
+static bool ParseArgs(int argc, char* argv[], ReplayOptions& options) {
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        if (arg.rfind("--", 0) != 0) {
+            fprintf(stderr, "Unrecognised argument: %s\n", arg.c_str());
+            return false;
+        }
+        //flags without a value are switches
+        const size_t eq = arg.find('=');
+        const std::string key = arg.substr(2, eq == std::string::npos ? std::string::npos : eq - 2);
+        const std::string value = eq == std::string::npos ? "true" : arg.substr(eq + 1);
+        if (key == "recording") options.recording = value;
+        else if (key == "target") options.target = value;
+        else if (key == "method") options.method = value;
+        else if (key == "speed" || key == "channels") {
+            //std::sto* throw on text that isn't a number or doesn't fit, which should print usage rather than abort
+            try {
+                if (key == "speed") options.speed = std::max(0.0, std::stod(value));
+                else options.channels = std::max(1, std::stoi(value));
+            }
+            catch (const std::logic_error&) {
+                fprintf(stderr, "Invalid number for --%s: %s\n", key.c_str(), value.c_str());
+                return false;
+            }
+        }
+        else if (key == "summary") options.summary = value != "false";
+        else {
+            fprintf(stderr, "Unknown option: --%s\n", key.c_str());
+            return false;
+        }
+    }
+    return !options.recording.empty();
+}
+
+static void PrintSummary(const std::vector<UnrealGrpc::FRecordedCall>& calls, std::chrono::system_clock::time_point wall_start) {
+    struct MethodSummary {
+        uint64_t calls = 0;
+        uint64_t request_bytes = 0;
+        uint64_t response_bytes = 0;
+        std::map<int, uint64_t> failures_by_code;
+        UnrealGrpc::FLatencyHistogram latency;
+    };
+    std::map<std::string, MethodSummary> methods;
+    for (const UnrealGrpc::FRecordedCall& call : calls) {
+        MethodSummary& summary = methods[call.Method];
+        summary.calls++;
+        summary.request_bytes += call.Request.size();
+        summary.response_bytes += call.Response.size();
+        summary.latency.Record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(call.Duration).count()));
+        if (call.Status != grpc::StatusCode::OK) summary.failures_by_code[call.Status]++;
+    }
+    const double seconds = calls.empty() ? 0.0 : std::chrono::duration<double>(calls.back().Start + calls.back().Duration).count();
+    const std::time_t started = std::chrono::system_clock::to_time_t(wall_start);
+    char started_text[32] = "";
+    std::strftime(started_text, sizeof(started_text), "%Y-%m-%d %H:%M:%S", std::localtime(&started));
+    printf("recorded:   %s, %zu calls over %.2fs\n", started_text, calls.size(), seconds);
+    const auto us = [](uint64_t nanos) { return static_cast<double>(nanos) / 1000.0; };
+    for (const auto& [method, summary] : methods) {
+        const auto average = [&summary](uint64_t bytes) { return static_cast<double>(bytes) / static_cast<double>(summary.calls); };
+        printf("%s\n  %llu calls, %.1f req/s, request %.1f bytes, response %.1f bytes on average\n", method.c_str(),
+            static_cast<unsigned long long>(summary.calls), seconds > 0 ? static_cast<double>(summary.calls) / seconds : 0.0,
+            average(summary.request_bytes), average(summary.response_bytes));
+        printf("  recorded latency p50 %.1fus  p99 %.1fus  max %.1fus\n",
+            us(summary.latency.GetPercentile(50)), us(summary.latency.GetPercentile(99)), us(summary.latency.GetMax()));
+        for (const auto& [code, count] : summary.failures_by_code) printf("  status %d: %llu\n", code, static_cast<unsigned long long>(count));
+    }
+}
+
+int main(int argc, char* argv[]) {
+    ReplayOptions options;
+    if (!ParseArgs(argc, argv, options)) {
+        PrintUsage();
+        return 2;
+    }
+
+    std::vector<UnrealGrpc::FRecordedCall> calls;
+    std::chrono::system_clock::time_point wall_start;
+    if (!UnrealGrpc::LoadRecording(options.recording, calls, &wall_start)) {
+        fprintf(stderr, "Could not read recording %s\n", options.recording.c_str());
+        return 1;
+    }
+    if (options.summary) {
+        PrintSummary(calls, wall_start);
+        return 0;
+    }
+
+    std::vector<std::string> methods;
+    for (const UnrealGrpc::FRecordedCall& call : calls) {
+        if (!options.method.empty() && call.Method != options.method) continue;
+        if (std::find(methods.begin(), methods.end(), call.Method) == methods.end()) methods.push_back(call.Method);
+    }
+    if (methods.empty()) {
+        fprintf(stderr, "No calls to replay in %s\n", options.recording.c_str());
+        return 1;
+    }
+
+    UnrealGrpc::FChannelPoolConfig config;
+    config.NumChannels = options.channels;
+    UnrealGrpc::FChannelPool pool(options.target, config);
+    std::vector<std::unique_ptr<grpc::GenericStub>> stubs;
+    for (int i = 0; i < pool.Num(); i++) stubs.push_back(std::make_unique<grpc::GenericStub>(pool.GetChannel(i)));
+
+    struct Call {
+        grpc::ClientContext context;
+        grpc::ByteBuffer request;
+        grpc::ByteBuffer response;
+        UnrealGrpc::FChannelPool::FLease lease;
+    };
+    UnrealGrpc::FTrafficReplay replay(calls, methods);
+    const auto start = std::chrono::steady_clock::now();
+    const std::vector<UnrealGrpc::FReplayMethodResult> results = replay.Run(options.speed,
+        [&](const UnrealGrpc::FRecordedCall& recorded, int32_t, UnrealGrpc::FTrafficReplay::FCompletion done) {
+            auto* call = new Call();
+            grpc::Slice slice(recorded.Request);
+            call->request = grpc::ByteBuffer(&slice, 1);
+            call->lease = pool.Acquire();
+            stubs[call->lease.GetIndex()]->UnaryCall(&call->context, recorded.Method, grpc::StubOptions(), &call->request, &call->response,
+                [call, done](const grpc::Status& status) {
+                    delete call;
+                    done(status);
+                });
+            return true;
+        });
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    printf("target:     %s (%d channel%s), speed %.2f\n", options.target.c_str(), options.channels, options.channels == 1 ? "" : "s", options.speed);
+    printf("replayed:   %zu methods in %.2fs\n", results.size(), seconds);
+    int32_t mismatches = 0;
+    for (size_t i = 0; i < results.size(); i++) {
+        const UnrealGrpc::FReplayMethodResult& result = results[i];
+        printf("%s\n  %d calls, %d with a different status than recorded\n", methods[i].c_str(), result.Calls, result.StatusMismatches);
+        printf("  latency p50 %.1fus  p99 %.1fus  max %.1fus\n", result.Call.P50Us, result.Call.P99Us, result.Call.MaxUs);
+        mismatches += result.StatusMismatches;
+    }
+    return mismatches == 0 ? 0 : 1;
+}
@@ -1,12 +1,19 @@
 ﻿#include <map>
+#include <optional>
 #include <set>
 #include <string>
+#include <vector>
 #include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
 #include <google/protobuf/compiler/code_generator.h>
 #include <google/protobuf/compiler/plugin.h>
 #include <google/protobuf/descriptor.h>
 #include <google/protobuf/io/printer.h>
 #include <google/protobuf/io/zero_copy_stream.h>
+#include <google/protobuf/unknown_field_set.h>
 #include <absl/strings/string_view.h>
 
 using namespace google::protobuf;
@@ -15,6 +22,59 @@ using namespace google::protobuf::compiler;
 static constexpr std::string_view kUPropVisible = "UPROPERTY(VisibleAnywhere, BlueprintReadOnly)\n";
 static constexpr std::string_view kUstructDeclaration = "USTRUCT(BlueprintType)\n";
 static constexpr std::string_view kConverterClassName = "ProtoToUStructConverter";
+static constexpr std::string_view kChannelPoolHeader = "UnrealGrpc/GrpcChannelPool.h";
+static constexpr std::string_view kLoopbackHeader = "UnrealGrpc/GrpcLoopback.h";
+static constexpr std::string_view kClientStatsHeader = "UnrealGrpc/GrpcClientStats.h";
+static constexpr std::string_view kCoalescerHeader = "UnrealGrpc/GrpcCoalescer.h";
+static constexpr std::string_view kResponseCacheHeader = "UnrealGrpc/GrpcResponseCache.h";
+static constexpr std::string_view kResilientCallHeader = "UnrealGrpc/GrpcResilientCall.h";
+static constexpr std::string_view kCompressionHeader = "UnrealGrpc/GrpcCompression.h";
+static constexpr std::string_view kPrewarmHeader = "UnrealGrpc/GrpcPrewarm.h";
+static constexpr std::string_view kCallbackCallHeader = "UnrealGrpc/GrpcCallbackCall.h";
+static constexpr std::string_view kCoroutineHeader = "UnrealGrpc/GrpcCoroutine.h";
+static constexpr std::string_view kStreamReaderHeader = "UnrealGrpc/GrpcStreamReader.h";
+static constexpr std::string_view kSerializationHeader = "UnrealGrpc/GrpcSerialization.h";
+static constexpr std::string_view kWireCodecHeader = "UnrealGrpc/GrpcWireCodec.h";
+static constexpr std::string_view kSpoolerHeader = "UnrealGrpc/GrpcSpooler.h";
+static constexpr std::string_view kTrafficRecorderHeader = "UnrealGrpc/GrpcTrafficRecorder.h";
+static constexpr std::string_view kStructHashHeader = "UnrealGrpc/GrpcStructHash.h";
+static constexpr std::string_view kNetSerializeHeader = "UnrealGrpc/GrpcNetSerialize.h";
+static constexpr std::string_view kQuantizeHeader = "UnrealGrpc/GrpcQuantize.h";
+
+//extension numbers from UnrealGrpc/unreal_options.proto
+static constexpr int kCacheTtlMsOption = 50001;
+static constexpr int kCacheMaxEntriesOption = 50002;
+static constexpr int kMaxAttemptsOption = 50003;
+static constexpr int kRetryBackoffMsOption = 50004;
+static constexpr int kHedgePercentileOption = 50005;
+static constexpr int kHedgeMinDelayMsOption = 50006;
+static constexpr int kCompressionOption = 50007;
+static constexpr int kCompressMinBytesOption = 50008;
+static constexpr int kWarmupOption = 50009;
+static constexpr int kDeadlineMsOption = 50010;
+static constexpr int kGameThreadOption = 50011;
+static constexpr int kStreamHighWatermarkOption = 50012;
+static constexpr int kStreamLowWatermarkOption = 50013;
+static constexpr int kStreamKeepLatestOption = 50014;
+static constexpr int kStreamLatestKeyOption = 50015;
+static constexpr int kSpoolOption = 50016;
+static constexpr int kSpoolBatchSizeOption = 50017;
+static constexpr int kSpoolFlushMsOption = 50018;
+static constexpr int kPrewarmOption = 50100;
+static constexpr int kPrewarmTimeoutMsOption = 50101;
+static constexpr int kDefaultDeadlineMsOption = 50102;
+static constexpr int kRecordOption = 50103;
+static constexpr int kPlainStructOption = 50200;
+static constexpr int kPlainStructsOption = 50300;
+static constexpr int kQuantizeMinOption = 50400;
+static constexpr int kQuantizeMaxOption = 50401;
+static constexpr int kQuantizePrecisionOption = 50402;
+//quantized values must convert to floats exactly
+static constexpr double kMaxQuantizeSteps = 16777216.0;
+static constexpr uint64_t kDefaultPrewarmTimeoutMs = 5000;
+static constexpr uint64_t kDefaultCacheMaxEntries = 256;
+static constexpr uint64_t kDefaultStreamHighWatermark = 64;
+static constexpr uint64_t kDefaultStreamLowWatermark = 16;
 
 class UnrealGenerator final : public CodeGenerator {
 public:
@@ -45,6 +105,7 @@ public:
             {FieldDescriptor::TYPE_INT32, "int32"}, {FieldDescriptor::TYPE_BOOL, "bool"},
             {FieldDescriptor::TYPE_STRING, "FString"}
         };
+        if (IsQuantized(field)) return "float";
         //enums and structs are special they are EFoo and FFoo respectively
         if (field->type() == FieldDescriptor::TYPE_MESSAGE) return "F" + std::string(field->message_type()->name());
         if (field->type() == FieldDescriptor::TYPE_ENUM) return "E" + std::string(field->enum_type()->name());
@@ -64,6 +125,31 @@ public:
         return base;
     }
 
+    static std::string GetBaseFilename(const FileDescriptor* file) {
+        auto base_filename = ToPascalCase(std::string(file->name()));
+        if (base_filename.find_last_of('.') != std::string::npos) base_filename = base_filename.substr(0, base_filename.find_last_of('.'));
+        return base_filename;
+    }
+
+    //fully qualified c++ name protoc gives a message or enum, e.g. game.Outer.Inner -> ::game::Outer::Inner
+    template <typename TDescriptor>
+    static std::string GetProtoCppType(const TDescriptor* desc) {
+        std::string result = "::";
+        for (const char c : desc->full_name()) {
+            if (c == '.') result += "::";
+            else result += c;
+        }
+        return result;
+    }
+
+    //the inverse of the conversions in GenerateStaticConversionFunction for a single value
+    static std::string GetToProtoValue(const FieldDescriptor* field, const std::string& value) {
+        if (IsQuantized(field)) return "UnrealGrpc::Quantize(" + value + ", " + GetQuantization(field) + ")";
+        if (field->type() == FieldDescriptor::TYPE_STRING) return "TCHAR_TO_UTF8(*" + value + ")";
+        if (field->type() == FieldDescriptor::TYPE_ENUM) return "static_cast<" + GetProtoCppType(field->enum_type()) + ">(" + value + ")";
+        return value;
+    }
+
     static void GenerateEnum(const EnumDescriptor* enum_desc, io::Printer& printer) {
         printer.Print({{"n", std::string(enum_desc->name())}},
             "UENUM(BlueprintType)\nenum class E$n$ : uint8 {\n");
@@ -84,13 +170,13 @@ public:
             GenerateNestedEnums(msg->nested_type(i), printer);
     }
 
-    static void GenerateOneofEnum(const Descriptor *msg, io::Printer &printer, const std::string &msg_name) {
+    static void GenerateOneofEnum(const Descriptor *msg, io::Printer &printer, const std::string &msg_name, bool reflected) {
         for (int i = 0; i < msg->oneof_decl_count(); i++) {
             const OneofDescriptor* oneof = msg->oneof_decl(i);
             //check for 'synthetic' oneofs. sometimes grpc creates a oneof as a backing field, those should not be converted.
             if (oneof->field(0)->real_containing_oneof() == nullptr) continue;
             std::string oneof_enum_name = msg_name + ToPascalCase(oneof->name());
-            printer.Print({{"n", oneof_enum_name}}, "UENUM(BlueprintType)\nenum class E$n$Type : uint8 {\n");
+            printer.Print({{"n", oneof_enum_name}, {"ue", reflected ? "UENUM(BlueprintType)\n" : ""}}, "$ue$enum class E$n$Type : uint8 {\n");
             printer.Indent();
             printer.Print("None = 0,\n");
             for (int j = 0; j < oneof->field_count(); j++) {
@@ -101,15 +187,123 @@ public:
         }
     }
 
-    static void GenerateStruct(const Descriptor* msg, io::Printer& printer) {
+    //fields whose UE type is a single number, bool or enum. strings, containers and the TOptionals that
+    //carry presence all own or track memory, so any of them makes the struct non-trivial
+    static bool IsPodField(const FieldDescriptor* field) {
+        static const std::set<std::string> pod_types = {"double", "float", "int64", "uint64", "int32", "bool"};
+        if (field->is_repeated() || field->has_presence()) return false;
+        if (field->type() == FieldDescriptor::TYPE_ENUM) return true;
+        return pod_types.contains(GetUEType(field));
+    }
+
+    static bool IsPodStruct(const Descriptor* msg) {
+        for (int i = 0; i < msg->field_count(); i++) if (!IsPodField(msg->field(i))) return false;
+        return true;
+    }
+
+    //hash and equality of one value of a field's base UE type. strings compare case-sensitively, unlike FString's ==,
+    //so a renamed entity shows up as a change
+    static std::string GetValueHash(const FieldDescriptor* field, const std::string& value) {
+        if (field->type() == FieldDescriptor::TYPE_MESSAGE) return "GetTypeHash(" + value + ")";
+        if (GetBaseUEType(field) == "FString") return "UnrealGrpc::HashBytes(*" + value + ", " + value + ".Len() * sizeof(TCHAR))";
+        return "UnrealGrpc::HashBits(" + value + ")";
+    }
+
+    static std::string GetValueEqual(const FieldDescriptor* field, const std::string& a, const std::string& b) {
+        if (GetBaseUEType(field) == "FString") return a + ".Equals(" + b + ", ESearchCase::CaseSensitive)";
+        return a + " == " + b;
+    }
+
+    static bool IsScalarField(const FieldDescriptor* field) {
+        return field->type() != FieldDescriptor::TYPE_MESSAGE && GetBaseUEType(field) != "FString";
+    }
+
+    static std::string GetFieldHash(const FieldDescriptor* field, const std::string& value) {
+        const std::string base = GetBaseUEType(field);
+        if (field->is_map()) {
+            const FieldDescriptor* key = field->message_type()->FindFieldByName("key");
+            const FieldDescriptor* val = field->message_type()->FindFieldByName("value");
+            //keys hash the way the TMap finds them, so case-insensitively for strings
+            return "UnrealGrpc::HashMap(" + value + ", [](const " + GetBaseUEType(key) + "& Key) { return GetTypeHash(Key); }, [](const " +
+                GetBaseUEType(val) + "& Value) { return " + GetValueHash(val, "Value") + "; })";
+        }
+        if (field->is_repeated()) {
+            if (IsScalarField(field)) return "UnrealGrpc::HashArray(" + value + ".GetData(), " + value + ".Num())";
+            return "UnrealGrpc::HashEach(" + value + ", [](const " + base + "& Value) { return " + GetValueHash(field, "Value") + "; })";
+        }
+        if (field->has_presence()) return value + ".IsSet() ? UnrealGrpc::HashMix(1, " + GetValueHash(field, value + ".GetValue()") + ") : 0";
+        return GetValueHash(field, value);
+    }
+
+    static std::string GetFieldEqual(const FieldDescriptor* field, const std::string& a, const std::string& b) {
+        if (field->is_map()) {
+            const FieldDescriptor* val = field->message_type()->FindFieldByName("value");
+            return "UnrealGrpc::MapsEqual(" + a + ", " + b + ", [](const " + GetBaseUEType(val) + "& A, const " + GetBaseUEType(val) + "& B) { return " +
+                GetValueEqual(val, "A", "B") + "; })";
+        }
+        if (field->is_repeated()) {
+            if (field->type() == FieldDescriptor::TYPE_MESSAGE || IsScalarField(field)) return a + " == " + b;
+            return "UnrealGrpc::ArraysEqual(" + a + ", " + b + ", [](const FString& A, const FString& B) { return " + GetValueEqual(field, "A", "B") + "; })";
+        }
+        if (field->has_presence()) {
+            return a + ".IsSet() == " + b + ".IsSet() && (!" + a + ".IsSet() || " + GetValueEqual(field, a + ".GetValue()", b + ".GetValue()") + ")";
+        }
+        return GetValueEqual(field, a, b);
+    }
+
+    //field-wise operator== and GetTypeHash, so structs can be TSet elements and TMap keys. singular numbers,
+    //bools and enums are hashed together by HashScalars; everything else is mixed in one field at a time
+    static void PrintEqualityAndHash(const Descriptor* msg, io::Printer& printer) {
+        const std::string msg_name = std::string(msg->name());
+        std::vector<std::string> equal;
+        std::vector<std::string> scalars;
+        std::vector<std::string> mixed;
+        for (int i = 0; i < msg->oneof_decl_count(); i++) {
+            const OneofDescriptor* oneof = msg->oneof_decl(i);
+            if (oneof->field(0)->real_containing_oneof() == nullptr) continue;
+            const std::string type = ToPascalCase(oneof->name()) + "Type";
+            equal.push_back(type + " == Other." + type);
+            scalars.push_back("In." + type);
+        }
+        for (int j = 0; j < msg->field_count(); j++) {
+            const FieldDescriptor* f = msg->field(j);
+            if (f->real_containing_oneof() == nullptr && f->containing_oneof() != nullptr) continue;
+            const std::string n = ToPascalCase(f->name());
+            equal.push_back(GetFieldEqual(f, n, "Other." + n));
+            if (!f->is_repeated() && !f->has_presence() && IsScalarField(f)) scalars.push_back("In." + n);
+            else mixed.push_back(GetFieldHash(f, "In." + n));
+        }
+        std::string equal_expr;
+        for (const std::string& e : equal) equal_expr += (equal_expr.empty() ? "" : " &&\n    ") + e;
+        printer.Print({{"n", msg_name}, {"eq", equal_expr.empty() ? "true" : equal_expr}},
+            "bool operator==(const F$n$& Other) const {\n"
+            "  return $eq$;\n"
+            "}\n\n"
+            "bool operator!=(const F$n$& Other) const {\n"
+            "  return !(*this == Other);\n"
+            "}\n\n"
+            "friend uint32 GetTypeHash(const F$n$& In) {\n");
+        std::string scalar_args;
+        for (const std::string& a : scalars) scalar_args += (scalar_args.empty() ? "" : ", ") + a;
+        printer.Print({{"args", scalar_args}}, "  uint64 Hash = UnrealGrpc::HashScalars($args$);\n");
+        for (const std::string& m : mixed) printer.Print({{"h", m}}, "  Hash = UnrealGrpc::HashMix(Hash, $h$);\n");
+        printer.Print(
+            "  return UnrealGrpc::FinalizeHash(Hash);\n"
+            "}\n\n");
+    }
+
+    //plain structs skip UHT entirely: no USTRUCT, UPROPERTY or generated header, and nothing for reflection to walk
+    static void GenerateStruct(const Descriptor* msg, bool net_serialize, io::Printer& printer) {
         auto msg_name = std::string(msg->name());
+        const bool reflected = !IsPlainStruct(msg);
         //oneof enum declaration is outside the struct. UE cannot declare UENUMS within struct bodies
-        GenerateOneofEnum(msg, printer, msg_name);
+        GenerateOneofEnum(msg, printer, msg_name, reflected);
 
-        printer.Print({{"n", msg_name}, {"us", kUstructDeclaration}},
+        const std::string up = reflected ? std::string(kUPropVisible) : "";
+        printer.Print({{"n", msg_name}, {"us", reflected ? kUstructDeclaration.data() : ""}},
             "$us$struct F$n$ {\n");
         printer.Indent();
-        printer.Print(
+        if (reflected) printer.Print(
             "GENERATED_BODY()\n\n");
         for (int i = 0; i < msg->oneof_decl_count(); i++) {
             const OneofDescriptor* oneof = msg->oneof_decl(i);
@@ -117,17 +311,36 @@ public:
             if (oneof->field(0)->real_containing_oneof() == nullptr) continue;
             //add the oneof enums.
             std::string oneof_enum_name = msg_name + ToPascalCase(oneof->name());
-            printer.Print({{"en", oneof_enum_name}, {"up", kUPropVisible.data()},{"sn", ToPascalCase(oneof->name())}},
+            printer.Print({{"en", oneof_enum_name}, {"up", up},{"sn", ToPascalCase(oneof->name())}},
                 "$up$E$en$Type $sn$Type = E$en$Type::None;\n\n");
         }
         for (int j = 0; j < msg->field_count(); j++) {
             const FieldDescriptor* f = msg->field(j);
             if (f->real_containing_oneof() == nullptr && f->containing_oneof() != nullptr) continue;
-            printer.Print({{"t", GetUEType(f)}, {"up", kUPropVisible.data()},{"n", ToPascalCase(f->name())}},
+            printer.Print({{"t", GetUEType(f)}, {"up", up},{"n", ToPascalCase(f->name())}},
                           "$up$$t$ $n$;\n\n");
         }
+        PrintEqualityAndHash(msg, printer);
+        const bool net = reflected && net_serialize;
+        if (net) printer.Print(
+            "//compact replication, defined in the file's NetSerialize.cpp\n"
+            "bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);\n\n");
         printer.Outdent();
         printer.Print("};\n");
+        if (!reflected) return;
+        //reflection compares with the generated == instead of property by property, e.g. when replication diffs.
+        //for POD structs all-zero memory is also a valid default and there is nothing to destroy, so the
+        //reflected struct ops can zero, memcpy and drop them without per-element constructors or destructors
+        printer.Print({{"n", msg_name}, {"pod", IsPodStruct(msg) ? "    WithZeroConstructor = true,\n    WithNoDestructor = true,\n" : ""},
+            {"net", net ? "    WithNetSerializer = true,\n" : ""}},
+            "\ntemplate <>\n"
+            "struct TStructOpsTypeTraits<F$n$> : public TStructOpsTypeTraitsBase2<F$n$> {\n"
+            "  enum {\n"
+            "$pod$"
+            "    WithIdenticalViaEquality = true,\n"
+            "$net$"
+            "  };\n"
+            "};\n");
     }
 
     //generate a static conversion function. this is wrapped in the plugin that converts the raw messages to
@@ -162,6 +375,8 @@ public:
                     "Out.$un_f$ = FString(UTF8_TO_TCHAR(In.$pn_f$().c_str()));\n");
                 else if (f->type() == FieldDescriptor::TYPE_ENUM) printer.Print(string_vars,
                     "Out.$un_f$ = static_cast<$et$>(In.$pn_f$());\n");
+                else if (IsQuantized(f)) printer.Print({{"un_f", string_vars["un_f"]}, {"pn_f", low_name}, {"q", GetQuantization(f)}},
+                    "Out.$un_f$ = UnrealGrpc::Dequantize(In.$pn_f$(), $q$);\n");
                 else printer.Print(string_vars,
                     "Out.$un_f$ = In.$pn_f$();\n");
                 printer.Print(string_vars,
@@ -193,6 +408,11 @@ public:
                 else printer.Print(printer_vars,
                     "Out.$un$.Add(P.first, P.second);\n");
                 printer.Outdent(); printer.Print("}\n");
+            } else if (f->is_repeated() && IsQuantized(f)) {
+                printer_vars["q"] = GetQuantization(f);
+                printer.Print(printer_vars,
+                    "Out.$un$.SetNumUninitialized(In.$pn$_size());\n"
+                    "UnrealGrpc::DequantizeArray(In.$pn$().data(), Out.$un$.GetData(), In.$pn$_size(), $q$);\n");
             } else if (f->is_repeated()) {
                 printer.Print(printer_vars,
                     "for (const auto& E : In.$pn$()) {\n");
@@ -211,6 +431,8 @@ public:
                 "Out.$un$ = FString(UTF8_TO_TCHAR(In.$pn$().c_str()));\n");
             else if (f->type() == FieldDescriptor::TYPE_ENUM) printer.Print(printer_vars,
                 "Out.$un$ = static_cast<$et$>(In.$pn$());\n");
+            else if (IsQuantized(f)) printer.Print({{"un", printer_vars["un"]}, {"pn", low_name}, {"q", GetQuantization(f)}},
+                "Out.$un$ = UnrealGrpc::Dequantize(In.$pn$(), $q$);\n");
             else printer.Print(printer_vars,
                 "Out.$un$ = In.$pn$();\n");
         }
@@ -218,9 +440,2016 @@ public:
         printer.Outdent(); printer.Print("}\n\n");
     }
 
+    //generate the reverse of Convert, used when a USTRUCT has to go back out over the wire
+    static void GenerateToProtoFunction(const Descriptor* msg, io::Printer& printer, const std::string& name_space) {
+        printer.Print({{"n", std::string(msg->name())}, {"ns", name_space}, {"cn", kConverterClassName}},
+            "void $cn$::ToProto(const F$n$& In, $ns$$n$& Out) {\n");
+        printer.Indent();
+
+        for (int i = 0; i < msg->oneof_decl_count(); i++) {
+            const OneofDescriptor* oneof = msg->oneof_decl(i);
+            if (oneof->field(0)->real_containing_oneof() == nullptr) continue;
+            std::string un_oneof = ToPascalCase(oneof->name());
+            printer.Print({{"un_t", un_oneof}},
+                "switch (In.$un_t$Type) {\n");
+            printer.Indent();
+            for (int j = 0; j < oneof->field_count(); j++) {
+                const FieldDescriptor* f = oneof->field(j);
+                auto low_name = std::string(f->name());
+                std::ranges::transform(low_name, low_name.begin(), ::tolower);
+                const std::string un_f = ToPascalCase(f->name());
+                std::map<std::string, std::string> string_vars = {
+                    {"un_f", un_f}, {"un_t", un_oneof}, {"pn_f", low_name}, {"mn", std::string(msg->name())},
+                    {"cn", kConverterClassName.data()}, {"v", GetToProtoValue(f, "In." + un_f + ".GetValue()")}
+                };
+                printer.Print(string_vars,
+                    "case E$mn$$un_t$Type::$un_f$:\n");
+                printer.Indent();
+                if (f->type() == FieldDescriptor::TYPE_MESSAGE) printer.Print(string_vars,
+                    "if (In.$un_f$.IsSet()) $cn$::ToProto(In.$un_f$.GetValue(), *Out.mutable_$pn_f$());\n");
+                else printer.Print(string_vars,
+                    "if (In.$un_f$.IsSet()) Out.set_$pn_f$($v$);\n");
+                printer.Print("break;\n");
+                printer.Outdent();
+            }
+            printer.Print("default: break;\n");
+            printer.Outdent();
+            printer.Print("}\n");
+        }
+
+        for (int j = 0; j < msg->field_count(); j++) {
+            const FieldDescriptor* f = msg->field(j);
+            //real oneof members were written by the switches above, synthetic ones have no UE field
+            if (f->containing_oneof() != nullptr) continue;
+            auto low_name = std::string(f->name());
+            std::ranges::transform(low_name, low_name.begin(), ::tolower);
+            const std::string un = ToPascalCase(f->name());
+            std::map<std::string, std::string> printer_vars = {{"un", un}, {"pn", low_name}, {"cn", kConverterClassName.data()}};
+
+            if (f->is_map()) {
+                const FieldDescriptor* kf = f->message_type()->FindFieldByName("key");
+                const FieldDescriptor* vf = f->message_type()->FindFieldByName("value");
+                printer_vars["k"] = GetToProtoValue(kf, "P.Key");
+                printer_vars["v"] = GetToProtoValue(vf, "P.Value");
+                printer.Print(printer_vars,
+                    "for (const auto& P : In.$un$) {\n");
+                printer.Indent();
+                if (vf->type() == FieldDescriptor::TYPE_MESSAGE) printer.Print(printer_vars,
+                    "$cn$::ToProto(P.Value, (*Out.mutable_$pn$())[$k$]);\n");
+                else printer.Print(printer_vars,
+                    "(*Out.mutable_$pn$())[$k$] = $v$;\n");
+                printer.Outdent(); printer.Print("}\n");
+            } else if (f->is_repeated() && IsQuantized(f)) {
+                //whole array at once, four values per instruction
+                printer_vars["q"] = GetQuantization(f);
+                printer.Print(printer_vars,
+                    "Out.mutable_$pn$()->Resize(In.$un$.Num(), 0);\n"
+                    "UnrealGrpc::QuantizeArray(In.$un$.GetData(), Out.mutable_$pn$()->mutable_data(), In.$un$.Num(), $q$);\n");
+            } else if (f->is_repeated()) {
+                printer_vars["v"] = GetToProtoValue(f, "E");
+                printer.Print(printer_vars,
+                    "Out.mutable_$pn$()->Reserve(In.$un$.Num());\n"
+                    "for (const auto& E : In.$un$) {\n");
+                printer.Indent();
+                if (f->type() == FieldDescriptor::TYPE_MESSAGE) printer.Print(printer_vars,
+                    "$cn$::ToProto(E, *Out.add_$pn$());\n");
+                else printer.Print(printer_vars,
+                    "Out.add_$pn$($v$);\n");
+                printer.Outdent(); printer.Print("}\n");
+            } else if (f->has_presence()) {
+                printer_vars["v"] = GetToProtoValue(f, "In." + un + ".GetValue()");
+                if (f->type() == FieldDescriptor::TYPE_MESSAGE) printer.Print(printer_vars,
+                    "if (In.$un$.IsSet()) $cn$::ToProto(In.$un$.GetValue(), *Out.mutable_$pn$());\n");
+                else printer.Print(printer_vars,
+                    "if (In.$un$.IsSet()) Out.set_$pn$($v$);\n");
+            } else {
+                printer_vars["v"] = GetToProtoValue(f, "In." + un);
+                printer.Print(printer_vars,
+                    "Out.set_$pn$($v$);\n");
+            }
+        }
+        printer.Outdent(); printer.Print("}\n\n");
+    }
+
+    struct GeneratorOptions {
+        //service clients need the --grpc_out headers, so they are opt-in like everything else beyond the data types
+        bool bGenerateClients = false;
+        //fake in-process servers plus a benchmark harness per service, for measuring call cost without a backend
+        bool bGenerateLoopback = false;
+        //<Method>Coalesced variants that fold identical in-flight requests into one RPC
+        bool bGenerateCoalescing = false;
+        //Async calls and stream entry points on gRPC's callback API instead of the pool's completion queue
+        bool bCallbackClients = false;
+        //<Method>Co awaitables for C++20 coroutines, off by default for toolchains without <coroutine>
+        bool bGenerateCoroutines = false;
+        //callback-API server base classes with USTRUCT handlers, for services hosted by dedicated servers
+        bool bGenerateServers = false;
+        //per-message helpers that serialize USTRUCTs straight into gRPC byte buffers, plus wire codecs and
+        //<Method>Direct calls for messages whose USTRUCT holds every field
+        bool bGenerateSerialization = false;
+        //NetSerialize for every USTRUCT with presence bits and varints, replacing property-by-property replication
+        bool bGenerateNetSerialize = false;
+    };
+
+    static bool ParseOptions(const std::string& parameter, GeneratorOptions& options, std::string* error) {
+        std::vector<std::pair<std::string, std::string>> pairs;
+        ParseGeneratorParameter(parameter, &pairs);
+        for (const auto& [key, value] : pairs) {
+            if (key == "clients") options.bGenerateClients = value != "false";
+            else if (key == "loopback") options.bGenerateLoopback = value != "false";
+            else if (key == "coalescing") options.bGenerateCoalescing = value != "false";
+            else if (key == "coroutines") options.bGenerateCoroutines = value != "false";
+            else if (key == "servers") options.bGenerateServers = value != "false";
+            else if (key == "serialization") options.bGenerateSerialization = value != "false";
+            else if (key == "net_serialize") options.bGenerateNetSerialize = value != "false";
+            else if (key == "client_api") {
+                if (value != "cq" && value != "callback") {
+                    *error = "client_api must be cq or callback, got: " + value;
+                    return false;
+                }
+                options.bCallbackClients = value == "callback";
+            } else {
+                *error = "Unknown unreal generator option: " + key;
+                return false;
+            }
+        }
+        if (options.bGenerateLoopback && !options.bGenerateClients) {
+            *error = "loopback benchmarks drive the generated clients and need clients=true";
+            return false;
+        }
+        if (options.bGenerateCoalescing && !options.bGenerateClients) {
+            *error = "coalescing is part of the generated clients and needs clients=true";
+            return false;
+        }
+        if (options.bGenerateCoroutines && !options.bGenerateClients) {
+            *error = "coroutines are part of the generated clients and need clients=true";
+            return false;
+        }
+        if (options.bCallbackClients && !options.bGenerateClients) {
+            *error = "client_api selects how the generated clients call and needs clients=true";
+            return false;
+        }
+        return true;
+    }
+
+    static std::map<std::string, std::string> GetMethodVars(const MethodDescriptor* method) {
+        return {
+            {"m", std::string(method->name())}, {"svc", std::string(method->service()->name())}, {"cn", kConverterClassName.data()},
+            {"req", "F" + std::string(method->input_type()->name())}, {"res", "F" + std::string(method->output_type()->name())},
+            {"preq", GetProtoCppType(method->input_type())}, {"pres", GetProtoCppType(method->output_type())},
+            {"path", "/" + std::string(method->service()->full_name()) + "/" + std::string(method->name())},
+            {"stat", "STAT_" + std::string(method->service()->name()) + "_" + std::string(method->name())}
+        };
+    }
+
+    static bool IsUnary(const MethodDescriptor* method) {
+        return !method->client_streaming() && !method->server_streaming();
+    }
+
+    //the plugin has no compiled-in copy of unreal_options.proto, so custom options arrive as unknown fields
+    static std::optional<uint64_t> GetVarintOption(const Message& options, int number) {
+        std::optional<uint64_t> result;
+        const UnknownFieldSet& unknown = options.GetReflection()->GetUnknownFields(options);
+        for (int i = 0; i < unknown.field_count(); i++) {
+            const UnknownField& field = unknown.field(i);
+            //the last occurrence wins, as it would for a parsed scalar
+            if (field.number() == number && field.type() == UnknownField::TYPE_VARINT) result = field.varint();
+        }
+        return result;
+    }
+
+    static std::optional<std::string> GetStringOption(const Message& options, int number) {
+        std::optional<std::string> result;
+        const UnknownFieldSet& unknown = options.GetReflection()->GetUnknownFields(options);
+        for (int i = 0; i < unknown.field_count(); i++) {
+            const UnknownField& field = unknown.field(i);
+            if (field.number() == number && field.type() == UnknownField::TYPE_LENGTH_DELIMITED) result = std::string(field.length_delimited());
+        }
+        return result;
+    }
+
+    static std::optional<float> GetFloatOption(const Message& options, int number) {
+        std::optional<float> result;
+        const UnknownFieldSet& unknown = options.GetReflection()->GetUnknownFields(options);
+        for (int i = 0; i < unknown.field_count(); i++) {
+            const UnknownField& field = unknown.field(i);
+            if (field.number() == number && field.type() == UnknownField::TYPE_FIXED32) result = std::bit_cast<float>(field.fixed32());
+        }
+        return result;
+    }
+
+    static bool IsQuantized(const FieldDescriptor* field) {
+        const FieldOptions& options = field->options();
+        return GetFloatOption(options, kQuantizeMinOption) || GetFloatOption(options, kQuantizeMaxOption) || GetFloatOption(options, kQuantizePrecisionOption);
+    }
+
+    //shortest literal that reads back as the same float
+    static std::string GetFloatLiteral(float value) {
+        char buffer[32];
+        for (int digits = 6; digits <= 9; digits++) {
+            snprintf(buffer, sizeof(buffer), "%.*g", digits, value);
+            if (strtof(buffer, nullptr) == value) break;
+        }
+        std::string literal = buffer;
+        if (literal.find_first_of(".e") == std::string::npos) literal += ".0";
+        return literal + "f";
+    }
+
+    static std::string GetQuantization(const FieldDescriptor* field) {
+        const FieldOptions& options = field->options();
+        return "UnrealGrpc::FQuantization{" + GetFloatLiteral(GetFloatOption(options, kQuantizeMinOption).value_or(0)) + ", " +
+            GetFloatLiteral(GetFloatOption(options, kQuantizeMaxOption).value_or(0)) + ", " +
+            GetFloatLiteral(GetFloatOption(options, kQuantizePrecisionOption).value_or(0)) + "}";
+    }
+
+    static bool HasQuantizedFields(const FileDescriptor* file) {
+        for (int i = 0; i < file->message_type_count(); i++) {
+            for (int j = 0; j < file->message_type(i)->field_count(); j++) if (IsQuantized(file->message_type(i)->field(j))) return true;
+        }
+        return false;
+    }
+
+    static bool ValidateQuantizeOptions(const FileDescriptor* file, std::string* error) {
+        for (int i = 0; i < file->message_type_count(); i++) {
+            for (int j = 0; j < file->message_type(i)->field_count(); j++) {
+                const FieldDescriptor* field = file->message_type(i)->field(j);
+                if (!IsQuantized(field)) continue;
+                const FieldOptions& options = field->options();
+                const std::optional<float> min = GetFloatOption(options, kQuantizeMinOption);
+                const std::optional<float> max = GetFloatOption(options, kQuantizeMaxOption);
+                const std::optional<float> precision = GetFloatOption(options, kQuantizePrecisionOption);
+                const std::string name = std::string(field->full_name());
+                if (field->type() != FieldDescriptor::TYPE_UINT32 || (field->has_presence() && !field->real_containing_oneof())) {
+                    *error = "quantized fields must be uint32 without optional: " + name;
+                    return false;
+                }
+                if (!min || !max || !precision) {
+                    *error = "quantized fields need quantize_min, quantize_max and quantize_precision: " + name;
+                    return false;
+                }
+                if (!std::isfinite(*min) || !std::isfinite(*max) || !(*max > *min) || !(*precision > 0)) {
+                    *error = "quantize_max must be above quantize_min and quantize_precision above 0: " + name;
+                    return false;
+                }
+                if ((static_cast<double>(*max) - *min) / *precision > kMaxQuantizeSteps) {
+                    *error = "quantized range holds more than 2^24 steps, which floats can't represent exactly; raise quantize_precision: " + name;
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    static uint64_t GetCacheTtlMs(const MethodDescriptor* method) {
+        return IsUnary(method) ? GetVarintOption(method->options(), kCacheTtlMsOption).value_or(0) : 0;
+    }
+
+    struct CallPolicy {
+        uint64_t max_attempts = 1;
+        uint64_t backoff_ms = 50;
+        uint64_t hedge_percentile = 0;
+        uint64_t hedge_min_delay_ms = 10;
+    };
+
+    static CallPolicy GetCallPolicy(const MethodDescriptor* method) {
+        CallPolicy policy;
+        if (!IsUnary(method)) return policy;
+        const Message& options = method->options();
+        policy.hedge_percentile = std::min<uint64_t>(GetVarintOption(options, kHedgePercentileOption).value_or(0), 99);
+        //hedging needs a second attempt, so it implies two unless more were asked for
+        policy.max_attempts = GetVarintOption(options, kMaxAttemptsOption).value_or(policy.hedge_percentile > 0 ? 2 : 1);
+        policy.backoff_ms = GetVarintOption(options, kRetryBackoffMsOption).value_or(policy.backoff_ms);
+        policy.hedge_min_delay_ms = GetVarintOption(options, kHedgeMinDelayMsOption).value_or(policy.hedge_min_delay_ms);
+        return policy;
+    }
+
+    static bool IsResilient(const MethodDescriptor* method) {
+        const CallPolicy policy = GetCallPolicy(method);
+        return policy.max_attempts > 1;
+    }
+
+    static bool IsHedged(const MethodDescriptor* method) {
+        const CallPolicy policy = GetCallPolicy(method);
+        return policy.max_attempts > 1 && policy.hedge_percentile > 0;
+    }
+
+    //grpc_compression_algorithm for the method's unreal.compression option, or empty when the method has no policy
+    static std::string GetCompressionAlgorithm(const MethodDescriptor* method) {
+        if (!IsUnary(method)) return "";
+        const auto compression = GetVarintOption(method->options(), kCompressionOption);
+        const auto min_bytes = GetVarintOption(method->options(), kCompressMinBytesOption);
+        if (!compression && !min_bytes) return "";
+        //values of unreal.Compression
+        switch (compression.value_or(0)) {
+            case 1: return "GRPC_COMPRESS_NONE";
+            case 2: return "GRPC_COMPRESS_DEFLATE";
+            default: return "GRPC_COMPRESS_GZIP";
+        }
+    }
+
+    //the message's own plain_struct wins, so a file of plain structs can keep a few reflected
+    static bool IsPlainStruct(const Descriptor* msg) {
+        const std::optional<uint64_t> plain = GetVarintOption(msg->options(), kPlainStructOption);
+        if (plain) return *plain != 0;
+        return GetVarintOption(msg->file()->options(), kPlainStructsOption).value_or(0) != 0;
+    }
+
+    static bool IsRecorded(const ServiceDescriptor* service) {
+        return GetVarintOption(service->options(), kRecordOption).value_or(0) != 0;
+    }
+
+    static bool IsPrewarmed(const ServiceDescriptor* service) {
+        return GetVarintOption(service->options(), kPrewarmOption).value_or(0) != 0;
+    }
+
+    static bool IsWarmupMethod(const MethodDescriptor* method) {
+        return IsUnary(method) && GetVarintOption(method->options(), kWarmupOption).value_or(0) != 0;
+    }
+
+    //the method's deadline_ms, else the service's default_deadline_ms; 0 leaves calls without a deadline
+    static uint64_t GetDeadlineMs(const MethodDescriptor* method) {
+        if (!IsUnary(method)) return 0;
+        return GetVarintOption(method->options(), kDeadlineMsOption)
+            .value_or(GetVarintOption(method->service()->options(), kDefaultDeadlineMsOption).value_or(0));
+    }
+
+    static std::string GetDeadlineExpression(const MethodDescriptor* method) {
+        return "std::chrono::system_clock::now() + std::chrono::milliseconds(" + std::to_string(GetDeadlineMs(method)) + ")";
+    }
+
+    static bool HasCachedMethods(const ServiceDescriptor* service) {
+        for (int i = 0; i < service->method_count(); i++) {
+            if (GetCacheTtlMs(service->method(i)) > 0) return true;
+        }
+        return false;
+    }
+
+    //parameters of the callback-API entry point for a streaming method, matching the stub's async() overload
+    static std::string GetStreamParameters(const MethodDescriptor* method) {
+        const auto vars = GetMethodVars(method);
+        if (method->client_streaming() && method->server_streaming()) {
+            return "grpc::ClientContext* Context, grpc::ClientBidiReactor<" + vars.at("preq") + ", " + vars.at("pres") + ">* Reactor";
+        }
+        if (method->server_streaming()) {
+            return "grpc::ClientContext* Context, const " + vars.at("preq") + "* Request, grpc::ClientReadReactor<" + vars.at("pres") + ">* Reactor";
+        }
+        return "grpc::ClientContext* Context, " + vars.at("pres") + "* Response, grpc::ClientWriteReactor<" + vars.at("preq") + ">* Reactor";
+    }
+
+    static std::string GetStreamArguments(const MethodDescriptor* method) {
+        if (method->client_streaming() && method->server_streaming()) return "Context, Reactor";
+        if (method->server_streaming()) return "Context, Request, Reactor";
+        return "Context, Response, Reactor";
+    }
+
+    static bool IsServerStreaming(const MethodDescriptor* method) {
+        return method->server_streaming() && !method->client_streaming();
+    }
+
+    //FStreamBufferConfig initializer from the method's stream options
+    static std::string GetStreamBufferConfig(const MethodDescriptor* method) {
+        const Message& options = method->options();
+        const uint64_t high = std::max<uint64_t>(GetVarintOption(options, kStreamHighWatermarkOption).value_or(kDefaultStreamHighWatermark), 1);
+        const uint64_t low = std::min(GetVarintOption(options, kStreamLowWatermarkOption).value_or(kDefaultStreamLowWatermark), high - 1);
+        const bool keep_latest = GetVarintOption(options, kStreamKeepLatestOption).value_or(0) != 0;
+        return "UnrealGrpc::FStreamBufferConfig{" + std::to_string(high) + ", " + std::to_string(low) + ", UnrealGrpc::EStreamOverflow::" +
+            (keep_latest ? "DropOldest" : "Pause") + "}";
+    }
+
+    //response field named by stream_latest_key, or null when the method has no latest-value reader
+    static const FieldDescriptor* GetLatestKeyField(const MethodDescriptor* method) {
+        if (!IsServerStreaming(method)) return nullptr;
+        const std::optional<std::string> name = GetStringOption(method->options(), kStreamLatestKeyOption);
+        return name ? method->output_type()->FindFieldByName(*name) : nullptr;
+    }
+
+    //C++ type the latest-value reader keys its map by, empty if the field can't be a key
+    static std::string GetLatestKeyType(const FieldDescriptor* field) {
+        if (field->is_repeated()) return "";
+        switch (field->cpp_type()) {
+        case FieldDescriptor::CPPTYPE_INT32: return "int32_t";
+        case FieldDescriptor::CPPTYPE_INT64: return "int64_t";
+        case FieldDescriptor::CPPTYPE_UINT32: return "uint32_t";
+        case FieldDescriptor::CPPTYPE_UINT64: return "uint64_t";
+        case FieldDescriptor::CPPTYPE_BOOL: return "bool";
+        case FieldDescriptor::CPPTYPE_ENUM: return "int32_t";
+        case FieldDescriptor::CPPTYPE_STRING: return "std::string";
+        default: return "";
+        }
+    }
+
+    static bool ValidateStreamOptions(const FileDescriptor* file, std::string* error) {
+        for (int i = 0; i < file->service_count(); i++) {
+            for (int j = 0; j < file->service(i)->method_count(); j++) {
+                const MethodDescriptor* method = file->service(i)->method(j);
+                const std::optional<std::string> name = GetStringOption(method->options(), kStreamLatestKeyOption);
+                if (!name) continue;
+                const std::string full_name(method->full_name());
+                if (!IsServerStreaming(method)) {
+                    *error = "stream_latest_key is only supported on server-streaming methods: " + full_name;
+                    return false;
+                }
+                const FieldDescriptor* field = method->output_type()->FindFieldByName(*name);
+                if (!field || GetLatestKeyType(field).empty()) {
+                    *error = "stream_latest_key of " + full_name + " must name a singular integer, bool, enum or string field of " +
+                        std::string(method->output_type()->full_name()) + ", got: " + *name;
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    static bool IsSpooled(const MethodDescriptor* method) {
+        return GetVarintOption(method->options(), kSpoolOption).value_or(0) != 0;
+    }
+
+    //the wrapper's only field when a unary spooled method takes its batch as a repeated message, else null
+    static const FieldDescriptor* GetSpoolBatchField(const MethodDescriptor* method) {
+        if (!IsUnary(method) || method->input_type()->field_count() != 1) return nullptr;
+        const FieldDescriptor* field = method->input_type()->field(0);
+        if (!field->is_repeated() || field->is_map() || field->type() != FieldDescriptor::TYPE_MESSAGE) return nullptr;
+        //nested messages get no USTRUCT of their own
+        if (field->message_type()->containing_type() != nullptr) return nullptr;
+        return field;
+    }
+
+    //message a spooled method sends one of per event: the stream's input or the wrapper's element
+    static const Descriptor* GetSpoolEventType(const MethodDescriptor* method) {
+        if (method->client_streaming() && !method->server_streaming()) return method->input_type();
+        const FieldDescriptor* field = GetSpoolBatchField(method);
+        return field ? field->message_type() : nullptr;
+    }
+
+    //UHT rejects a UPROPERTY whose type it has never seen, so a USTRUCT can't hold a plain struct
+    static bool ValidatePlainStructs(const FileDescriptor* file, std::string* error) {
+        for (int i = 0; i < file->message_type_count(); i++) {
+            const Descriptor* msg = file->message_type(i);
+            if (msg->options().map_entry() || IsPlainStruct(msg)) continue;
+            for (int j = 0; j < msg->field_count(); j++) {
+                const FieldDescriptor* f = msg->field(j);
+                if (f->type() != FieldDescriptor::TYPE_MESSAGE) continue;
+                const FieldDescriptor* value = f->is_map() ? f->message_type()->FindFieldByName("value") : f;
+                if (value->type() != FieldDescriptor::TYPE_MESSAGE || !IsPlainStruct(value->message_type())) continue;
+                *error = "reflected message " + std::string(msg->full_name()) + " cannot hold plain struct " + std::string(value->message_type()->full_name()) +
+                    " in field " + std::string(f->name()) + "; set plain_struct on both or neither";
+                return false;
+            }
+        }
+        return true;
+    }
+
+    static bool ValidateSpoolOptions(const FileDescriptor* file, std::string* error) {
+        for (int i = 0; i < file->service_count(); i++) {
+            for (int j = 0; j < file->service(i)->method_count(); j++) {
+                const MethodDescriptor* method = file->service(i)->method(j);
+                if (!IsSpooled(method) || GetSpoolEventType(method) != nullptr) continue;
+                *error = "spool needs a client-streaming method, or a unary method whose request holds only a repeated top-level message: " +
+                    std::string(method->full_name());
+                return false;
+            }
+        }
+        return true;
+    }
+
+    static std::string GetStreamAwaitableType(const MethodDescriptor* method) {
+        const auto vars = GetMethodVars(method);
+        if (!method->client_streaming()) return "UnrealGrpc::TServerStreamAwaitable<" + vars.at("pres") + ", " + vars.at("res") + ">";
+        const std::string args = vars.at("preq") + ", " + vars.at("pres") + ", " + vars.at("req") + ", " + vars.at("res") + ">";
+        if (!method->server_streaming()) return "UnrealGrpc::TClientStreamAwaitable<" + args;
+        return "UnrealGrpc::TBidiStreamAwaitable<" + args;
+    }
+
+    static void GenerateServiceClientDeclaration(const ServiceDescriptor* service, const GeneratorOptions& options, io::Printer& printer) {
+        printer.Print({{"svc", std::string(service->name())}, {"fn", std::string(service->full_name())},
+                {"thread", options.bCallbackClients ? "gRPC's callback threads" : "the pool's polling thread"}},
+            "/**\n"
+            " * Client for $fn$. Calls are spread across the channels of an FChannelPool, which\n"
+            " * can be shared between clients. Async callbacks run on $thread$.\n"
+            " * Per-method stats are available from UnrealGrpc::FClientStats when the pool comes from CreatePool.\n"
+            " * Pass a token from an UnrealGrpc::FCancellationSource owned by a level or frame to cancel its calls with it.\n"
+            " */\n"
+            "class F$svc$Client {\n"
+            "public:\n");
+        printer.Indent();
+        printer.Print({{"svc", std::string(service->name())}, {"record", IsRecorded(service) ? ", and the recording interceptor that FTrafficRecorder drives" : ""}},
+            "explicit F$svc$Client(std::shared_ptr<UnrealGrpc::FChannelPool> InPool);\n\n"
+            "/** Pool to Target with the stats interceptor installed on every channel$record$. */\n"
+            "static std::shared_ptr<UnrealGrpc::FChannelPool> CreatePool(const std::string& Target, UnrealGrpc::FChannelPoolConfig Config = {});\n\n");
+        for (int i = 0; i < service->method_count(); i++) {
+            const MethodDescriptor* method = service->method(i);
+            if (!IsUnary(method)) continue;
+            if (IsResilient(method)) {
+                printer.Print(GetMethodVars(method),
+                    "/**\n"
+                    " * Blocks until the retries and hedges, which run on the pool's polling thread, settle. Called from an\n"
+                    " * Async callback it would deadlock, so there it fails with FAILED_PRECONDITION instead; use $m$Async.\n"
+                    " */\n");
+            }
+            printer.Print(GetMethodVars(method),
+                "grpc::Status $m$(const $req$& Request, $res$& OutResponse, const UnrealGrpc::FCancellationToken& Cancellation = {});\n"
+                "void $m$Async(const $req$& Request, TFunction<void(const grpc::Status&, const $res$&)> OnComplete, const UnrealGrpc::FCancellationToken& Cancellation = {});\n");
+            if (options.bGenerateCoalescing) {
+                printer.Print(GetMethodVars(method),
+                    "/** Like $m$Async, but joins an identical request already in flight instead of sending another. Shared calls can't be cancelled. */\n"
+                    "void $m$Coalesced(const $req$& Request, TFunction<void(const grpc::Status&, const $res$&)> OnComplete);\n");
+            }
+            if (options.bGenerateCoroutines) {
+                printer.Print(GetMethodVars(method),
+                    "/** co_await-able $m$ that resumes on Executor. Goes straight to the server, without the cache, coalescing or retries. */\n"
+                    "UnrealGrpc::TUnaryAwaitable<$pres$, $res$> $m$Co(const $req$& Request, UnrealGrpc::FExecutor& Executor, const UnrealGrpc::FCancellationToken& Cancellation = {});\n");
+            }
+            if (options.bGenerateSerialization && IsDirectMethod(method)) {
+                printer.Print(GetMethodVars(method),
+                    "/** $m$ with the USTRUCTs going straight to and from the wire through their TWireCodec. Skips the cache, retries and compression. */\n"
+                    "grpc::Status $m$Direct(const $req$& Request, $res$& OutResponse, const UnrealGrpc::FCancellationToken& Cancellation = {});\n"
+                    "/** $m$Direct on gRPC's callback API. The call holds only the USTRUCTs and gRPC's buffers while in flight. */\n"
+                    "void $m$DirectAsync(const $req$& Request, TFunction<void(const grpc::Status&, const $res$&)> OnComplete, const UnrealGrpc::FCancellationToken& Cancellation = {});\n");
+            }
+            printer.Print("\n");
+        }
+        for (int i = 0; i < service->method_count(); i++) {
+            const MethodDescriptor* method = service->method(i);
+            if (!IsServerStreaming(method)) continue;
+            auto vars = GetMethodVars(method);
+            vars["config"] = GetStreamBufferConfig(method);
+            printer.Print(vars,
+                "/** Starts $m$ into a bounded buffer that the caller pops from, converting messages on gRPC's threads. */\n"
+                "std::shared_ptr<UnrealGrpc::TBufferedStreamReader<$pres$, $res$>> $m$Buffered(const $req$& Request,\n"
+                "  const UnrealGrpc::FStreamBufferConfig& Config = $config$, const UnrealGrpc::FCancellationToken& Cancellation = {});\n\n");
+            if (const FieldDescriptor* key = GetLatestKeyField(method)) {
+                vars["key"] = GetLatestKeyType(key);
+                vars["field"] = std::string(key->name());
+                printer.Print(vars,
+                    "/** Starts $m$, keeping only the newest message per $field$ and converting it when consumed. */\n"
+                    "std::shared_ptr<UnrealGrpc::TLatestValueStreamReader<$pres$, $res$, $key$>> $m$Latest(const $req$& Request,\n"
+                    "  const UnrealGrpc::FCancellationToken& Cancellation = {});\n\n");
+            }
+        }
+        for (int i = 0; options.bGenerateCoroutines && i < service->method_count(); i++) {
+            const MethodDescriptor* method = service->method(i);
+            if (IsUnary(method)) continue;
+            auto vars = GetMethodVars(method);
+            vars["type"] = GetStreamAwaitableType(method);
+            vars["params"] = method->client_streaming() ? "" : "const " + vars["req"] + "& Request, ";
+            printer.Print(vars,
+                "/** $m$ driven by co_await, resuming on Executor. Await Finish before it goes out of scope. */\n"
+                "$type$ $m$Co($params$UnrealGrpc::FExecutor& Executor, const UnrealGrpc::FCancellationToken& Cancellation = {});\n\n");
+        }
+        for (int i = 0; options.bCallbackClients && i < service->method_count(); i++) {
+            const MethodDescriptor* method = service->method(i);
+            if (IsUnary(method)) continue;
+            auto vars = GetMethodVars(method);
+            vars["params"] = GetStreamParameters(method);
+            printer.Print(vars,
+                "/** Binds the reactor to the least loaded channel; call StartCall on it next. The stream isn't counted as load. */\n"
+                "void $m$($params$);\n\n");
+        }
+        for (int i = 0; i < service->method_count(); i++) {
+            const MethodDescriptor* method = service->method(i);
+            if (!IsSpooled(method)) continue;
+            auto vars = GetMethodVars(method);
+            vars["ev"] = "F" + std::string(GetSpoolEventType(method)->name());
+            vars["pev"] = GetProtoCppType(GetSpoolEventType(method));
+            printer.Print(vars,
+                "/** Queues Event for the next $m$ batch without blocking. Returns false if the spooler is full and the event was dropped. */\n"
+                "bool $m$Spooled($ev$ Event) { return $m$Spooler->Enqueue(MoveTemp(Event)); }\n"
+                "/** For Flush and the delivery counters. */\n"
+                "UnrealGrpc::TSpooler<$ev$, $pev$>& Get$m$Spooler() const { return *$m$Spooler; }\n\n");
+        }
+        printer.Print({{"ps", GetProtoCppType(service)}},
+            "/** Stub bound to the channel behind a lease, for methods without a wrapper such as streams. */\n"
+            "$ps$::Stub& GetStub(const UnrealGrpc::FChannelPool::FLease& Lease) const { return *(*Stubs)[Lease.GetIndex()]; }\n"
+            "const std::shared_ptr<UnrealGrpc::FChannelPool>& GetPool() const { return Pool; }\n\n");
+        if (HasCachedMethods(service)) {
+            printer.Print(
+                "/** Drops every cached response, e.g. after a call that changes what cached reads would return. */\n"
+                "void ClearResponseCaches();\n\n");
+        }
+        if (IsPrewarmed(service)) {
+            printer.Print(
+                "/**\n"
+                " * Construction starts connecting every channel in the background and then makes the warm-up calls,\n"
+                " * so create the client during startup. Resolves to whether every channel connected in time.\n"
+                " */\n"
+                "const std::shared_future<bool>& GetWarmup() const { return Warmup; }\n"
+                "bool IsWarm() const { return Warmup.wait_for(std::chrono::seconds(0)) == std::future_status::ready && Warmup.get(); }\n\n");
+        }
+        printer.Outdent();
+        printer.Print("private:\n");
+        printer.Indent();
+        printer.Print({{"ps", GetProtoCppType(service)}},
+            "std::shared_ptr<UnrealGrpc::FChannelPool> Pool;\n"
+            "//one stub per pooled channel, indexed by lease; shared with retries that can outlive the client\n"
+            "std::shared_ptr<std::vector<std::unique_ptr<$ps$::Stub>>> Stubs = std::make_shared<std::vector<std::unique_ptr<$ps$::Stub>>>();\n");
+        if (IsPrewarmed(service)) printer.Print("std::shared_future<bool> Warmup;\n");
+        for (int i = 0; options.bGenerateCoalescing && i < service->method_count(); i++) {
+            const MethodDescriptor* method = service->method(i);
+            if (!IsUnary(method)) continue;
+            //shared so completions that outlive the client still have somewhere to deliver
+            printer.Print(GetMethodVars(method),
+                "std::shared_ptr<UnrealGrpc::TCallCoalescer<$res$>> $m$Coalescer = std::make_shared<UnrealGrpc::TCallCoalescer<$res$>>();\n");
+        }
+        for (int i = 0; i < service->method_count(); i++) {
+            const MethodDescriptor* method = service->method(i);
+            const uint64_t ttl_ms = GetCacheTtlMs(method);
+            if (ttl_ms == 0) continue;
+            auto vars = GetMethodVars(method);
+            vars["ttl"] = std::to_string(ttl_ms);
+            vars["max"] = std::to_string(GetVarintOption(method->options(), kCacheMaxEntriesOption).value_or(kDefaultCacheMaxEntries));
+            printer.Print(vars,
+                "std::shared_ptr<UnrealGrpc::TResponseCache<$res$>> $m$Cache = std::make_shared<UnrealGrpc::TResponseCache<$res$>>(std::chrono::milliseconds($ttl$), $max$);\n");
+        }
+        for (int i = 0; i < service->method_count(); i++) {
+            const MethodDescriptor* method = service->method(i);
+            const std::string algorithm = GetCompressionAlgorithm(method);
+            if (algorithm.empty()) continue;
+            auto vars = GetMethodVars(method);
+            vars["algorithm"] = algorithm;
+            vars["min"] = std::to_string(GetVarintOption(method->options(), kCompressMinBytesOption).value_or(0));
+            printer.Print(vars, "const UnrealGrpc::FCompressionPolicy $m$Compression{$algorithm$, $min$};\n");
+        }
+        for (int i = 0; i < service->method_count(); i++) {
+            const MethodDescriptor* method = service->method(i);
+            if (!IsResilient(method)) continue;
+            const CallPolicy policy = GetCallPolicy(method);
+            auto vars = GetMethodVars(method);
+            vars["attempts"] = std::to_string(policy.max_attempts);
+            vars["backoff"] = std::to_string(policy.backoff_ms);
+            vars["pct"] = std::to_string(policy.hedge_percentile);
+            vars["delay"] = std::to_string(policy.hedge_min_delay_ms);
+            printer.Print(vars, "const UnrealGrpc::FCallPolicy $m$Policy{$attempts$, std::chrono::milliseconds($backoff$)};\n");
+            if (IsHedged(method)) {
+                printer.Print(vars,
+                    "UnrealGrpc::FHedgeDelay $m$HedgeDelay{UnrealGrpc::FClientStats::Get().FindOrAdd(\"$path$\"), $pct$, std::chrono::milliseconds($delay$)};\n");
+            }
+        }
+        for (int i = 0; i < service->method_count(); i++) {
+            const MethodDescriptor* method = service->method(i);
+            if (!IsSpooled(method)) continue;
+            //declared last so the final flush in its destructor still sees the rest of the client
+            printer.Print({{"m", std::string(method->name())}, {"ev", "F" + std::string(GetSpoolEventType(method)->name())},
+                    {"pev", GetProtoCppType(GetSpoolEventType(method))}},
+                "std::unique_ptr<UnrealGrpc::TSpooler<$ev$, $pev$>> $m$Spooler;\n");
+        }
+        printer.Outdent();
+        printer.Print("};\n\n");
+    }
+
+    //stats handle, conversion timer and ToProto shared by every call variant
+    static void PrintCallPrologue(const std::map<std::string, std::string>& vars, bool cached, io::Printer& printer) {
+        printer.Print(vars,
+            "static UnrealGrpc::FMethodStats& MethodStats = UnrealGrpc::FClientStats::Get().FindOrAdd(\"$path$\");\n"
+            "UnrealGrpc::FConversionTimer Conversion(MethodStats);\n"
+            "$preq$ ProtoRequest;\n"
+            "Conversion.Time([&] { SCOPE_CYCLE_COUNTER($stat$_Convert); $cn$::ToProto(Request, ProtoRequest); });\n");
+        if (cached) printer.Print("std::string Key = UnrealGrpc::SerializeDeterministic(ProtoRequest);\n");
+    }
+
+    //the attempt factory handed to TResilientCall, which may call it again for hedges and retries
+    static void PrintResilientStart(const MethodDescriptor* method, io::Printer& printer) {
+        auto vars = GetMethodVars(method);
+        const bool compressed = !GetCompressionAlgorithm(method).empty();
+        vars["hedge"] = IsHedged(method) ? vars["m"] + "HedgeDelay.Get()" : "std::chrono::nanoseconds::zero()";
+        vars["compression"] = compressed ? "Compression = " + vars["m"] + "Compression, " : "";
+        //the deadline covers the whole call, so retries and hedges share the one taken here
+        const bool deadline = GetDeadlineMs(method) > 0;
+        vars["deadline"] = deadline ? "Deadline = " + GetDeadlineExpression(method) + ", " : "";
+        printer.Print(vars,
+            "UnrealGrpc::TResilientCall<$pres$>::Start(*Pool, $m$Policy, $hedge$,\n"
+            "  [Stubs = Stubs, $compression$$deadline$ProtoRequest = MoveTemp(ProtoRequest)](grpc::ClientContext* Context, const UnrealGrpc::FChannelPool::FLease& Lease, grpc::CompletionQueue* Queue) {\n");
+        if (compressed) printer.Print("    Compression.Apply(*Context, ProtoRequest);\n");
+        if (deadline) printer.Print("    Context->set_deadline(Deadline);\n");
+        printer.Print(vars,
+            "    return (*Stubs)[Lease.GetIndex()]->PrepareAsync$m$(Context, ProtoRequest, Queue);\n"
+            "  },\n");
+    }
+
+    //starts the async call; the completion converts once, fills the cache and then runs `deliver`
+    static void PrintAsyncCall(const MethodDescriptor* method, const std::string& captures, const std::string& deliver, bool cancellable,
+        const GeneratorOptions& options, io::Printer& printer) {
+        auto vars = GetMethodVars(method);
+        const bool cached = GetCacheTtlMs(method) > 0;
+        const bool resilient = IsResilient(method);
+        vars["captures"] = captures + (cached ? ", Cache = " + vars["m"] + "Cache" : "");
+        vars["deliver"] = deliver;
+        vars["deadline"] = GetDeadlineExpression(method);
+        vars["token"] = resilient && cancellable ? ", Cancellation" : "";
+        //retries and hedges are timed with alarms on the pool's queue, so they stay there in callback mode
+        const bool callback = options.bCallbackClients && !resilient;
+        //the callback call owns the request, since gRPC reads it after Start returns
+        vars["request"] = callback ? "Call->Request" : "ProtoRequest";
+        if (resilient) PrintResilientStart(method, printer);
+        else if (callback) printer.Print(vars, "auto* Call = new UnrealGrpc::TCallbackUnaryCall<$preq$, $pres$>(Pool->Acquire(), MoveTemp(ProtoRequest),\n");
+        else printer.Print(vars, "auto* Call = new UnrealGrpc::TAsyncUnaryCall<$pres$>(Pool->Acquire(),\n");
+        printer.Print(vars,
+            "  [$captures$, Conversion](const grpc::Status& Status, const $pres$& Response) mutable {\n"
+            "    $res$ Converted;\n"
+            "    if (Status.ok()) Conversion.Time([&] { SCOPE_CYCLE_COUNTER($stat$_Convert); Converted = $cn$::Convert(Response); });\n"
+            "    Conversion.Commit();\n");
+        if (cached) printer.Print("    if (Status.ok()) Cache->Add(Key, Converted, Response.ByteSizeLong());\n");
+        printer.Print(vars,
+            "    $deliver$;\n"
+            "  }$token$);\n");
+        if (!resilient) {
+            if (!GetCompressionAlgorithm(method).empty()) printer.Print(vars, "$m$Compression.Apply(Call->Context, $request$);\n");
+            if (GetDeadlineMs(method) > 0) printer.Print(vars, "Call->Context.set_deadline($deadline$);\n");
+            if (cancellable) printer.Print("Call->Cancellation = Cancellation.Register(Call->Context);\n");
+            if (callback) {
+                printer.Print(vars,
+                    "(*Stubs)[Call->GetChannelIndex()]->async()->$m$(&Call->Context, &Call->Request, &Call->Response, Call);\n"
+                    "Call->StartCall();\n");
+            } else {
+                printer.Print(vars,
+                    "Call->Start((*Stubs)[Call->GetChannelIndex()]->PrepareAsync$m$(&Call->Context, ProtoRequest, Pool->GetCompletionQueue()));\n");
+            }
+        }
+    }
+
+    //the call is prepared on the caller's thread, so the lambda can borrow the request by reference
+    static void PrintUnaryCoroutine(const MethodDescriptor* method, io::Printer& printer) {
+        auto vars = GetMethodVars(method);
+        printer.Print(vars,
+            "UnrealGrpc::TUnaryAwaitable<$pres$, $res$> F$svc$Client::$m$Co(const $req$& Request, UnrealGrpc::FExecutor& Executor, const UnrealGrpc::FCancellationToken& Cancellation) {\n"
+            "  $preq$ ProtoRequest;\n"
+            "  $cn$::ToProto(Request, ProtoRequest);\n"
+            "  return UnrealGrpc::TUnaryAwaitable<$pres$, $res$>(*Pool, Executor, &$cn$::Convert, Cancellation,\n"
+            "    [&](grpc::ClientContext* Context, int32 ChannelIndex, grpc::CompletionQueue* Queue) {\n");
+        if (!GetCompressionAlgorithm(method).empty()) printer.Print(vars, "      $m$Compression.Apply(*Context, ProtoRequest);\n");
+        if (GetDeadlineMs(method) > 0) printer.Print("      Context->set_deadline($deadline$);\n", "deadline", GetDeadlineExpression(method));
+        printer.Print(vars,
+            "      return (*Stubs)[ChannelIndex]->PrepareAsync$m$(Context, ProtoRequest, Queue);\n"
+            "    });\n"
+            "}\n\n");
+    }
+
+    static void PrintStreamCoroutine(const MethodDescriptor* method, io::Printer& printer) {
+        auto vars = GetMethodVars(method);
+        vars["type"] = GetStreamAwaitableType(method);
+        if (!method->client_streaming()) {
+            printer.Print(vars,
+                "$type$ F$svc$Client::$m$Co(const $req$& Request, UnrealGrpc::FExecutor& Executor, const UnrealGrpc::FCancellationToken& Cancellation) {\n"
+                "  $preq$ ProtoRequest;\n"
+                "  $cn$::ToProto(Request, ProtoRequest);\n"
+                "  return $type$(*Pool, Executor, nullptr, &$cn$::Convert, Cancellation,\n"
+                "    [&](grpc::ClientContext* Context, int32 ChannelIndex, grpc::CompletionQueue* Queue) {\n"
+                "      return (*Stubs)[ChannelIndex]->PrepareAsync$m$(Context, ProtoRequest, Queue);\n"
+                "    });\n"
+                "}\n\n");
+        } else if (!method->server_streaming()) {
+            printer.Print(vars,
+                "$type$ F$svc$Client::$m$Co(UnrealGrpc::FExecutor& Executor, const UnrealGrpc::FCancellationToken& Cancellation) {\n"
+                "  return $type$(*Pool, Executor, &$cn$::ToProto, &$cn$::Convert, Cancellation,\n"
+                "    [&](grpc::ClientContext* Context, int32 ChannelIndex, grpc::CompletionQueue* Queue, $pres$* Response) {\n"
+                "      return (*Stubs)[ChannelIndex]->PrepareAsync$m$(Context, Response, Queue);\n"
+                "    });\n"
+                "}\n\n");
+        } else {
+            printer.Print(vars,
+                "$type$ F$svc$Client::$m$Co(UnrealGrpc::FExecutor& Executor, const UnrealGrpc::FCancellationToken& Cancellation) {\n"
+                "  return $type$(*Pool, Executor, &$cn$::ToProto, &$cn$::Convert, Cancellation,\n"
+                "    [&](grpc::ClientContext* Context, int32 ChannelIndex, grpc::CompletionQueue* Queue) {\n"
+                "      return (*Stubs)[ChannelIndex]->PrepareAsync$m$(Context, Queue);\n"
+                "    });\n"
+                "}\n\n");
+        }
+    }
+
+    //calls typed on the USTRUCTs themselves, serialized by the SerializationTraits in <File>Serialization.h
+    static void PrintDirectCalls(const MethodDescriptor* method, io::Printer& printer) {
+        auto vars = GetMethodVars(method);
+        const std::string deadline = GetDeadlineMs(method) > 0 ? GetDeadlineExpression(method) : "";
+        printer.Print(vars,
+            "static const grpc::internal::RpcMethod& Get$svc$$m$Method() {\n"
+            "  static const grpc::internal::RpcMethod Method(\"$path$\", grpc::internal::RpcMethod::NORMAL_RPC);\n"
+            "  return Method;\n"
+            "}\n\n"
+            "grpc::Status F$svc$Client::$m$Direct(const $req$& Request, $res$& OutResponse, const UnrealGrpc::FCancellationToken& Cancellation) {\n"
+            "  SCOPE_CYCLE_COUNTER($stat$);\n"
+            "  grpc::ClientContext Context;\n");
+        if (!deadline.empty()) printer.Print("  Context.set_deadline($deadline$);\n", "deadline", deadline);
+        printer.Print(vars,
+            "  const UnrealGrpc::FCancellationToken::FRegistration Registration = Cancellation.Register(Context);\n"
+            "  const UnrealGrpc::FChannelPool::FLease Lease = Pool->Acquire();\n"
+            "  //interceptors can't read a USTRUCT response on their own\n"
+            "  const UnrealGrpc::FScopedRecvCodec RecvCodec(UnrealGrpc::TWireSerializationTraits<$res$>::RecvCodec);\n"
+            "  return grpc::internal::BlockingUnaryCall<$req$, $res$>(Pool->GetChannel(Lease.GetIndex()).get(), Get$svc$$m$Method(), &Context, Request, &OutResponse);\n"
+            "}\n\n"
+            "void F$svc$Client::$m$DirectAsync(const $req$& Request, TFunction<void(const grpc::Status&, const $res$&)> OnComplete, const UnrealGrpc::FCancellationToken& Cancellation) {\n"
+            "  auto* Call = new UnrealGrpc::TCallbackUnaryCall<$req$, $res$>(Pool->Acquire(), $req$(Request), MoveTemp(OnComplete));\n");
+        if (!deadline.empty()) printer.Print("  Call->Context.set_deadline($deadline$);\n", "deadline", deadline);
+        printer.Print(vars,
+            "  Call->Cancellation = Cancellation.Register(Call->Context);\n"
+            "  const UnrealGrpc::FScopedRecvCodec RecvCodec(UnrealGrpc::TWireSerializationTraits<$res$>::RecvCodec);\n"
+            "  grpc::internal::ClientCallbackUnaryFactory::Create<$req$, $res$>(Pool->GetChannel(Call->GetChannelIndex()).get(), Get$svc$$m$Method(),\n"
+            "    &Call->Context, &Call->Request, &Call->Response, Call);\n"
+            "  Call->StartCall();\n"
+            "}\n\n");
+    }
+
+    //constructor body that creates a spooled method's TSpooler and the call it sends each batch with
+    static void PrintSpoolerSetup(const MethodDescriptor* method, io::Printer& printer) {
+        const Message& method_options = method->options();
+        auto vars = GetMethodVars(method);
+        vars["ev"] = "F" + std::string(GetSpoolEventType(method)->name());
+        vars["pev"] = GetProtoCppType(GetSpoolEventType(method));
+        printer.Print(vars,
+            "  {\n"
+            "    using FSpooler = UnrealGrpc::TSpooler<$ev$, $pev$>;\n"
+            "    UnrealGrpc::FSpoolConfig Config;\n");
+        if (const auto batch_size = GetVarintOption(method_options, kSpoolBatchSizeOption)) {
+            printer.Print("    Config.BatchSize = $n$;\n", "n", std::to_string(*batch_size));
+        }
+        if (const auto flush_ms = GetVarintOption(method_options, kSpoolFlushMsOption)) {
+            printer.Print("    Config.FlushInterval = std::chrono::milliseconds($n$);\n", "n", std::to_string(*flush_ms));
+        }
+        if (GetDeadlineMs(method) > 0) printer.Print("    Config.SendTimeout = std::chrono::milliseconds($n$);\n", "n", std::to_string(GetDeadlineMs(method)));
+        printer.Print(vars,
+            "    Config.SpillPath = TCHAR_TO_UTF8(*FPaths::Combine(FPaths::ProjectSavedDir(), TEXT(\"UnrealGrpc\"), TEXT(\"$svc$.$m$.spool\")));\n");
+        if (const FieldDescriptor* field = GetSpoolBatchField(method)) {
+            const bool compressed = !GetCompressionAlgorithm(method).empty();
+            vars["field"] = std::string(field->lowercase_name());
+            vars["compression"] = compressed ? ", Compression = " + vars["m"] + "Compression" : "";
+            printer.Print(vars,
+                "    $m$Spooler = std::make_unique<FSpooler>(Config, FSpooler::FConvert(&$cn$::ToProto),\n"
+                "      [Pool = Pool, Stubs = Stubs$compression$](std::vector<$pev$>& Batch, std::chrono::system_clock::time_point Deadline) {\n"
+                "        $preq$ Request;\n"
+                "        auto* Events = Request.mutable_$field$();\n"
+                "        Events->Reserve(static_cast<int>(Batch.size()));\n"
+                "        for ($pev$& Event : Batch) Events->Add(std::move(Event));\n"
+                "        $pres$ Response;\n"
+                "        grpc::ClientContext Context;\n"
+                "        Context.set_deadline(Deadline);\n");
+            if (compressed) printer.Print("        Compression.Apply(Context, Request);\n");
+            printer.Print(vars,
+                "        const UnrealGrpc::FChannelPool::FLease Lease = Pool->Acquire();\n"
+                "        const grpc::Status Status = (*Stubs)[Lease.GetIndex()]->$m$(&Context, Request, &Response);\n"
+                "        //hand the events back, the spooler spills them if the server couldn't be reached\n"
+                "        for (int i = 0; i < Events->size(); i++) Batch[i] = std::move(*Events->Mutable(i));\n"
+                "        return Status;\n"
+                "      });\n"
+                "  }\n");
+            return;
+        }
+        printer.Print(vars,
+            "    $m$Spooler = std::make_unique<FSpooler>(Config, FSpooler::FConvert(&$cn$::ToProto),\n"
+            "      [Pool = Pool, Stubs = Stubs](std::vector<$pev$>& Batch, std::chrono::system_clock::time_point Deadline) {\n"
+            "        $pres$ Response;\n"
+            "        grpc::ClientContext Context;\n"
+            "        Context.set_deadline(Deadline);\n"
+            "        const UnrealGrpc::FChannelPool::FLease Lease = Pool->Acquire();\n"
+            "        const std::unique_ptr<grpc::ClientWriter<$preq$>> Writer = (*Stubs)[Lease.GetIndex()]->$m$(&Context, &Response);\n"
+            "        for (const $pev$& Event : Batch) {\n"
+            "          if (!Writer->Write(Event)) break;\n"
+            "        }\n"
+            "        Writer->WritesDone();\n"
+            "        return Writer->Finish();\n"
+            "      });\n"
+            "  }\n");
+    }
+
+    static void GenerateServiceClientDefinition(const ServiceDescriptor* service, const GeneratorOptions& options, io::Printer& printer) {
+        printer.Print({{"svc", std::string(service->name())}, {"ps", GetProtoCppType(service)}},
+            "F$svc$Client::F$svc$Client(std::shared_ptr<UnrealGrpc::FChannelPool> InPool) : Pool(MoveTemp(InPool)) {\n"
+            "  for (int32 i = 0; i < Pool->Num(); i++) Stubs->push_back($ps$::NewStub(Pool->GetChannel(i)));\n");
+        if (IsPrewarmed(service)) {
+            const uint64_t timeout_ms = GetVarintOption(service->options(), kPrewarmTimeoutMsOption).value_or(kDefaultPrewarmTimeoutMs);
+            printer.Print("  Warmup = UnrealGrpc::PrewarmPool(Pool, std::chrono::milliseconds($t$), {\n", "t", std::to_string(timeout_ms));
+            for (int i = 0; i < service->method_count(); i++) {
+                const MethodDescriptor* method = service->method(i);
+                if (!IsWarmupMethod(method)) continue;
+                //default request, result ignored: the call only exists to warm the connection and the server
+                printer.Print(GetMethodVars(method),
+                    "    [Stubs = Stubs](int32 ChannelIndex, std::chrono::system_clock::time_point Deadline) {\n"
+                    "      grpc::ClientContext Context;\n"
+                    "      Context.set_deadline(Deadline);\n"
+                    "      $pres$ Response;\n"
+                    "      (*Stubs)[ChannelIndex]->$m$(&Context, $preq$(), &Response);\n"
+                    "    },\n");
+            }
+            printer.Print("  });\n");
+        }
+        for (int i = 0; i < service->method_count(); i++) {
+            if (IsSpooled(service->method(i))) PrintSpoolerSetup(service->method(i), printer);
+        }
+        printer.Print({{"svc", std::string(service->name())}},
+            "}\n\n"
+            "std::shared_ptr<UnrealGrpc::FChannelPool> F$svc$Client::CreatePool(const std::string& Target, UnrealGrpc::FChannelPoolConfig Config) {\n"
+            "  Config.InterceptorFactories.push_back([] { return std::make_unique<UnrealGrpc::FStatsInterceptorFactory>(); });\n");
+        if (IsRecorded(service)) {
+            printer.Print("  Config.InterceptorFactories.push_back([] { return std::make_unique<UnrealGrpc::FRecordingInterceptorFactory>(); });\n");
+        }
+        printer.Print(
+            "  return std::make_shared<UnrealGrpc::FChannelPool>(Target, Config);\n"
+            "}\n\n");
+        if (HasCachedMethods(service)) {
+            printer.Print({{"svc", std::string(service->name())}}, "void F$svc$Client::ClearResponseCaches() {\n");
+            for (int i = 0; i < service->method_count(); i++) {
+                if (GetCacheTtlMs(service->method(i)) > 0) printer.Print("  $m$Cache->Clear();\n", "m", std::string(service->method(i)->name()));
+            }
+            printer.Print("}\n\n");
+        }
+        for (int i = 0; i < service->method_count(); i++) {
+            const MethodDescriptor* method = service->method(i);
+            if (!IsUnary(method)) continue;
+            const auto vars = GetMethodVars(method);
+            const bool cached = GetCacheTtlMs(method) > 0;
+
+            printer.Print(vars,
+                "grpc::Status F$svc$Client::$m$(const $req$& Request, $res$& OutResponse, const UnrealGrpc::FCancellationToken& Cancellation) {\n");
+            printer.Indent();
+            printer.Print(vars, "SCOPE_CYCLE_COUNTER($stat$);\n");
+            if (IsResilient(method)) {
+                //the polling thread would be waiting on itself
+                printer.Print(vars,
+                    "if (Pool->IsPollingThread()) {\n"
+                    "  return grpc::Status(grpc::StatusCode::FAILED_PRECONDITION, \"$svc$.$m$ blocks on the pool's polling thread; call $m$Async from completion callbacks\");\n"
+                    "}\n");
+            }
+            PrintCallPrologue(vars, cached, printer);
+            if (cached) printer.Print(vars, "if ($m$Cache->Find(Key, OutResponse)) return grpc::Status::OK;\n");
+            if (IsResilient(method)) {
+                //retries and hedges run on the completion queue, so the blocking call waits for their outcome
+                printer.Print(vars,
+                    "$pres$ ProtoResponse;\n"
+                    "auto Done = std::make_shared<std::promise<grpc::Status>>();\n"
+                    "std::future<grpc::Status> Result = Done->get_future();\n");
+                PrintResilientStart(method, printer);
+                printer.Print(vars,
+                    "  [Done, &ProtoResponse](const grpc::Status& Status, const $pres$& Response) {\n"
+                    "    if (Status.ok()) ProtoResponse = Response;\n"
+                    "    Done->set_value(Status);\n"
+                    "  }, Cancellation);\n"
+                    "const grpc::Status Status = Result.get();\n");
+            } else {
+                printer.Print(vars,
+                    "$pres$ ProtoResponse;\n"
+                    "grpc::ClientContext Context;\n");
+                if (!GetCompressionAlgorithm(method).empty()) printer.Print(vars, "$m$Compression.Apply(Context, ProtoRequest);\n");
+                if (GetDeadlineMs(method) > 0) printer.Print("Context.set_deadline($deadline$);\n", "deadline", GetDeadlineExpression(method));
+                printer.Print(vars,
+                    "const UnrealGrpc::FCancellationToken::FRegistration Registration = Cancellation.Register(Context);\n"
+                    "const UnrealGrpc::FChannelPool::FLease Lease = Pool->Acquire();\n"
+                    "const grpc::Status Status = (*Stubs)[Lease.GetIndex()]->$m$(&Context, ProtoRequest, &ProtoResponse);\n");
+            }
+            printer.Print(vars,
+                "if (Status.ok()) Conversion.Time([&] { SCOPE_CYCLE_COUNTER($stat$_Convert); OutResponse = $cn$::Convert(ProtoResponse); });\n"
+                "Conversion.Commit();\n");
+            if (cached) printer.Print(vars, "if (Status.ok()) $m$Cache->Add(Key, OutResponse, ProtoResponse.ByteSizeLong());\n");
+            printer.Print("return Status;\n");
+            printer.Outdent();
+            printer.Print("}\n\n");
+
+            printer.Print(vars,
+                "void F$svc$Client::$m$Async(const $req$& Request, TFunction<void(const grpc::Status&, const $res$&)> OnComplete, const UnrealGrpc::FCancellationToken& Cancellation) {\n");
+            printer.Indent();
+            PrintCallPrologue(vars, cached, printer);
+            //cache hits complete on the calling thread
+            if (cached) {
+                printer.Print(vars,
+                    "if ($res$ Cached; $m$Cache->Find(Key, Cached)) {\n"
+                    "  OnComplete(grpc::Status::OK, Cached);\n"
+                    "  return;\n"
+                    "}\n");
+            }
+            PrintAsyncCall(method, cached ? "OnComplete = MoveTemp(OnComplete), Key = MoveTemp(Key)" : "OnComplete = MoveTemp(OnComplete)",
+                "OnComplete(Status, Converted)", true, options, printer);
+            printer.Outdent();
+            printer.Print("}\n\n");
+
+            if (options.bGenerateCoroutines) PrintUnaryCoroutine(method, printer);
+            if (options.bGenerateSerialization && IsDirectMethod(method)) PrintDirectCalls(method, printer);
+
+            if (!options.bGenerateCoalescing) continue;
+            printer.Print(vars,
+                "void F$svc$Client::$m$Coalesced(const $req$& Request, TFunction<void(const grpc::Status&, const $res$&)> OnComplete) {\n");
+            printer.Indent();
+            PrintCallPrologue(vars, true, printer);
+            if (cached) {
+                printer.Print(vars,
+                    "if ($res$ Cached; $m$Cache->Find(Key, Cached)) {\n"
+                    "  OnComplete(grpc::Status::OK, Cached);\n"
+                    "  return;\n"
+                    "}\n");
+            }
+            printer.Print(vars, "if (!$m$Coalescer->Join(Key, MoveTemp(OnComplete))) return;\n");
+            //converted once and shared by every caller that joined
+            PrintAsyncCall(method, "Coalescer = " + vars.at("m") + "Coalescer, Key = MoveTemp(Key)", "Coalescer->Complete(Key, Status, Converted)", false, options, printer);
+            printer.Outdent();
+            printer.Print("}\n\n");
+        }
+        for (int i = 0; i < service->method_count(); i++) {
+            const MethodDescriptor* method = service->method(i);
+            if (!IsServerStreaming(method)) continue;
+            auto vars = GetMethodVars(method);
+            //the request is serialized by StartCall, which Start makes before returning, so it can stay on this stack
+            printer.Print(vars,
+                "std::shared_ptr<UnrealGrpc::TBufferedStreamReader<$pres$, $res$>> F$svc$Client::$m$Buffered(const $req$& Request,\n"
+                "  const UnrealGrpc::FStreamBufferConfig& Config, const UnrealGrpc::FCancellationToken& Cancellation) {\n"
+                "  $preq$ ProtoRequest;\n"
+                "  $cn$::ToProto(Request, ProtoRequest);\n"
+                "  return UnrealGrpc::TBufferedStreamReader<$pres$, $res$>::Start(*Pool, Config, &$cn$::Convert, Cancellation,\n"
+                "    [&](grpc::ClientContext* Context, grpc::ClientReadReactor<$pres$>* Reactor, int32 ChannelIndex) {\n"
+                "      (*Stubs)[ChannelIndex]->async()->$m$(Context, &ProtoRequest, Reactor);\n"
+                "    });\n"
+                "}\n\n");
+            const FieldDescriptor* key = GetLatestKeyField(method);
+            if (!key) continue;
+            vars["key"] = GetLatestKeyType(key);
+            vars["field"] = std::string(key->name());
+            //enum getters return the enum type, which the map can't take as int32_t implicitly
+            vars["get"] = key->cpp_type() == FieldDescriptor::CPPTYPE_ENUM ? "static_cast<int32_t>(In." + vars["field"] + "())" : "In." + vars["field"] + "()";
+            printer.Print(vars,
+                "std::shared_ptr<UnrealGrpc::TLatestValueStreamReader<$pres$, $res$, $key$>> F$svc$Client::$m$Latest(const $req$& Request,\n"
+                "  const UnrealGrpc::FCancellationToken& Cancellation) {\n"
+                "  $preq$ ProtoRequest;\n"
+                "  $cn$::ToProto(Request, ProtoRequest);\n"
+                "  return UnrealGrpc::TLatestValueStreamReader<$pres$, $res$, $key$>::Start(*Pool, &$cn$::Convert,\n"
+                "    [](const $pres$& In) -> $key$ { return $get$; }, Cancellation,\n"
+                "    [&](grpc::ClientContext* Context, grpc::ClientReadReactor<$pres$>* Reactor, int32 ChannelIndex) {\n"
+                "      (*Stubs)[ChannelIndex]->async()->$m$(Context, &ProtoRequest, Reactor);\n"
+                "    });\n"
+                "}\n\n");
+        }
+        for (int i = 0; options.bGenerateCoroutines && i < service->method_count(); i++) {
+            if (!IsUnary(service->method(i))) PrintStreamCoroutine(service->method(i), printer);
+        }
+        for (int i = 0; options.bCallbackClients && i < service->method_count(); i++) {
+            const MethodDescriptor* method = service->method(i);
+            if (IsUnary(method)) continue;
+            auto vars = GetMethodVars(method);
+            vars["params"] = GetStreamParameters(method);
+            vars["args"] = GetStreamArguments(method);
+            //the lease only picks the channel; streams live too long to hold one
+            printer.Print(vars,
+                "void F$svc$Client::$m$($params$) {\n"
+                "  (*Stubs)[Pool->Acquire().GetIndex()]->async()->$m$($args$);\n"
+                "}\n\n");
+        }
+    }
+
+    //request/response types can come from imported files, which have their own converter headers
+    static std::set<std::string> GetConverterHeaders(const FileDescriptor* file, const std::string& base_filename) {
+        std::set<std::string> converter_headers = {base_filename + "Converter.h"};
+        for (int i = 0; i < file->service_count(); i++) {
+            for (int j = 0; j < file->service(i)->method_count(); j++) {
+                const MethodDescriptor* method = file->service(i)->method(j);
+                converter_headers.insert(GetBaseFilename(method->input_type()->file()) + "Converter.h");
+                converter_headers.insert(GetBaseFilename(method->output_type()->file()) + "Converter.h");
+                if (IsSpooled(method)) converter_headers.insert(GetBaseFilename(GetSpoolEventType(method)->file()) + "Converter.h");
+            }
+        }
+        return converter_headers;
+    }
+
+    static void GenerateServiceClients(const FileDescriptor* file, const std::string& base_filename, const GeneratorOptions& options, GeneratorContext* context) {
+        const std::set<std::string> converter_headers = GetConverterHeaders(file, base_filename);
+
+        const std::unique_ptr<io::ZeroCopyOutputStream> h_out(context->Open(base_filename + "Client.h"));
+        io::Printer h_p(h_out.get(), '$');
+        h_p.Print({{"b", base_filename}, {"cp", kChannelPoolHeader}, {"cs", kClientStatsHeader}},
+            "#pragma once\n#include \"CoreMinimal.h\"\n#include \"$cp$\"\n#include \"$cs$\"\n#include \"$b$.grpc.pb.h\"\n");
+        if (options.bGenerateCoalescing) h_p.Print("#include \"$h$\"\n", "h", kCoalescerHeader);
+        bool any_cached = false;
+        for (int i = 0; i < file->service_count(); i++) any_cached |= HasCachedMethods(file->service(i));
+        if (any_cached) h_p.Print("#include \"$h$\"\n", "h", kResponseCacheHeader);
+        bool any_resilient = false;
+        for (int i = 0; i < file->service_count(); i++) {
+            for (int j = 0; j < file->service(i)->method_count(); j++) any_resilient |= IsResilient(file->service(i)->method(j));
+        }
+        if (any_resilient) h_p.Print("#include \"$h$\"\n", "h", kResilientCallHeader);
+        bool any_compressed = false;
+        for (int i = 0; i < file->service_count(); i++) {
+            for (int j = 0; j < file->service(i)->method_count(); j++) any_compressed |= !GetCompressionAlgorithm(file->service(i)->method(j)).empty();
+        }
+        if (any_compressed) h_p.Print("#include \"$h$\"\n", "h", kCompressionHeader);
+        bool any_prewarmed = false;
+        for (int i = 0; i < file->service_count(); i++) any_prewarmed |= IsPrewarmed(file->service(i));
+        if (any_prewarmed) h_p.Print("#include \"$h$\"\n", "h", kPrewarmHeader);
+        bool any_direct = false;
+        for (int i = 0; options.bGenerateSerialization && i < file->service_count(); i++) {
+            for (int j = 0; j < file->service(i)->method_count(); j++) any_direct |= IsDirectMethod(file->service(i)->method(j));
+        }
+        if (options.bCallbackClients || any_direct) h_p.Print("#include \"$h$\"\n", "h", kCallbackCallHeader);
+        if (options.bGenerateCoroutines) h_p.Print("#include \"$h$\"\n", "h", kCoroutineHeader);
+        bool any_server_streams = false;
+        for (int i = 0; i < file->service_count(); i++) {
+            for (int j = 0; j < file->service(i)->method_count(); j++) any_server_streams |= IsServerStreaming(file->service(i)->method(j));
+        }
+        if (any_server_streams) h_p.Print("#include \"$h$\"\n", "h", kStreamReaderHeader);
+        bool any_spooled = false;
+        for (int i = 0; i < file->service_count(); i++) {
+            for (int j = 0; j < file->service(i)->method_count(); j++) any_spooled |= IsSpooled(file->service(i)->method(j));
+        }
+        if (any_spooled) h_p.Print("#include \"$h$\"\n", "h", kSpoolerHeader);
+        bool any_recorded = false;
+        for (int i = 0; i < file->service_count(); i++) any_recorded |= IsRecorded(file->service(i));
+        if (any_recorded) h_p.Print("#include \"$h$\"\n", "h", kTrafficRecorderHeader);
+        for (const auto& header : converter_headers) h_p.Print("#include \"$h$\"\n", "h", header);
+        //the Direct calls need the SerializationTraits of their request and response types
+        std::set<std::string> serialization_headers;
+        for (int i = 0; any_direct && i < file->service_count(); i++) {
+            for (int j = 0; j < file->service(i)->method_count(); j++) {
+                const MethodDescriptor* method = file->service(i)->method(j);
+                if (!IsDirectMethod(method)) continue;
+                serialization_headers.insert(GetBaseFilename(method->input_type()->file()) + "Serialization.h");
+                serialization_headers.insert(GetBaseFilename(method->output_type()->file()) + "Serialization.h");
+            }
+        }
+        for (const auto& header : serialization_headers) h_p.Print("#include \"$h$\"\n", "h", header);
+        //every generated client header declares the group, so guard against several landing in one translation unit
+        h_p.Print("\n"
+            "#ifndef UNREALGRPC_STATGROUP_DECLARED\n"
+            "#define UNREALGRPC_STATGROUP_DECLARED\n"
+            "DECLARE_STATS_GROUP(TEXT(\"UnrealGrpc\"), STATGROUP_UnrealGrpc, STATCAT_Advanced);\n"
+            "#endif\n\n");
+        for (int i = 0; i < file->service_count(); i++) GenerateServiceClientDeclaration(file->service(i), options, h_p);
+
+        const std::unique_ptr<io::ZeroCopyOutputStream> cpp_out(context->Open(base_filename + "Client.cpp"));
+        io::Printer cpp_p(cpp_out.get(), '$');
+        cpp_p.Print({{"b", base_filename}}, "#include \"$b$Client.h\"\n");
+        if (any_spooled) cpp_p.Print("#include \"Misc/Paths.h\"\n");
+        cpp_p.Print("\n");
+        for (int i = 0; i < file->service_count(); i++) {
+            for (int j = 0; j < file->service(i)->method_count(); j++) {
+                const MethodDescriptor* method = file->service(i)->method(j);
+                if (!IsUnary(method)) continue;
+                cpp_p.Print(GetMethodVars(method),
+                    "DECLARE_CYCLE_STAT(TEXT(\"$svc$.$m$\"), $stat$, STATGROUP_UnrealGrpc);\n"
+                    "DECLARE_CYCLE_STAT(TEXT(\"$svc$.$m$ Convert\"), $stat$_Convert, STATGROUP_UnrealGrpc);\n");
+            }
+        }
+        cpp_p.Print("\n");
+        for (int i = 0; i < file->service_count(); i++) GenerateServiceClientDefinition(file->service(i), options, cpp_p);
+    }
+
+    static bool IsGameThreadMethod(const MethodDescriptor* method) {
+        return IsUnary(method) && GetVarintOption(method->options(), kGameThreadOption).value_or(0) != 0;
+    }
+
+    static void GenerateServerDeclaration(const ServiceDescriptor* service, io::Printer& printer) {
+        printer.Print({{"svc", std::string(service->name())}, {"fn", std::string(service->full_name())}, {"ps", GetProtoCppType(service)}},
+            "/**\n"
+            " * Base for implementing $fn$ on gRPC's callback API. Override the Handle methods: requests\n"
+            " * arrive as USTRUCTs converted on a gRPC thread, and responses are converted back off the game\n"
+            " * thread. Handlers that aren't overridden answer UNIMPLEMENTED. Streaming methods keep the\n"
+            " * reactor signatures of CallbackService.\n"
+            " */\n"
+            "class F$svc$ServerBase : public $ps$::CallbackService {\n"
+            "public:\n");
+        printer.Indent();
+        for (int i = 0; i < service->method_count(); i++) {
+            const MethodDescriptor* method = service->method(i);
+            if (!IsUnary(method)) continue;
+            auto vars = GetMethodVars(method);
+            vars["thread"] = IsGameThreadMethod(method) ? "the game thread" : "a gRPC thread; keep it short, it holds that thread";
+            printer.Print(vars,
+                "/** Runs on $thread$. */\n"
+                "virtual grpc::Status Handle$m$(grpc::CallbackServerContext& Context, const $req$& Request, $res$& OutResponse);\n");
+        }
+        printer.Print("\n");
+        for (int i = 0; i < service->method_count(); i++) {
+            const MethodDescriptor* method = service->method(i);
+            if (IsUnary(method)) printer.Print(GetMethodVars(method),
+                "grpc::ServerUnaryReactor* $m$(grpc::CallbackServerContext* Context, const $preq$* Request, $pres$* Response) final;\n");
+        }
+        printer.Outdent();
+        printer.Print("};\n\n");
+    }
+
+    static void GenerateServerDefinition(const ServiceDescriptor* service, io::Printer& printer) {
+        for (int i = 0; i < service->method_count(); i++) {
+            const MethodDescriptor* method = service->method(i);
+            if (!IsUnary(method)) continue;
+            const auto vars = GetMethodVars(method);
+            printer.Print(vars,
+                "grpc::Status F$svc$ServerBase::Handle$m$(grpc::CallbackServerContext& Context, const $req$& Request, $res$& OutResponse) {\n"
+                "  return grpc::Status(grpc::StatusCode::UNIMPLEMENTED, \"\");\n"
+                "}\n\n"
+                "grpc::ServerUnaryReactor* F$svc$ServerBase::$m$(grpc::CallbackServerContext* Context, const $preq$* Request, $pres$* Response) {\n");
+            printer.Indent();
+            printer.Print("grpc::ServerUnaryReactor* Reactor = Context->DefaultReactor();\n");
+            if (IsGameThreadMethod(method)) {
+                //only the handler runs on the game thread; both conversions stay off it
+                printer.Print(vars,
+                    "AsyncTask(ENamedThreads::GameThread, [this, Context, Reactor, Response, Converted = $cn$::Convert(*Request)]() {\n"
+                    "  $res$ Result;\n"
+                    "  const grpc::Status Status = Handle$m$(*Context, Converted, Result);\n"
+                    "  AsyncTask(ENamedThreads::AnyBackgroundThreadNormalTask, [Reactor, Response, Status, Result = MoveTemp(Result)]() {\n"
+                    "    if (Status.ok()) $cn$::ToProto(Result, *Response);\n"
+                    "    Reactor->Finish(Status);\n"
+                    "  });\n"
+                    "});\n");
+            } else {
+                printer.Print(vars,
+                    "$res$ Result;\n"
+                    "const grpc::Status Status = Handle$m$(*Context, $cn$::Convert(*Request), Result);\n"
+                    "if (Status.ok()) $cn$::ToProto(Result, *Response);\n"
+                    "Reactor->Finish(Status);\n");
+            }
+            printer.Print("return Reactor;\n");
+            printer.Outdent();
+            printer.Print("}\n\n");
+        }
+    }
+
+    static void GenerateServers(const FileDescriptor* file, const std::string& base_filename, GeneratorContext* context) {
+        const std::unique_ptr<io::ZeroCopyOutputStream> h_out(context->Open(base_filename + "Server.h"));
+        io::Printer h_p(h_out.get(), '$');
+        h_p.Print({{"b", base_filename}},
+            "#pragma once\n#include \"CoreMinimal.h\"\n#include \"Async/Async.h\"\n#include \"$b$.grpc.pb.h\"\n");
+        for (const auto& header : GetConverterHeaders(file, base_filename)) h_p.Print("#include \"$h$\"\n", "h", header);
+        h_p.Print("\n");
+        for (int i = 0; i < file->service_count(); i++) GenerateServerDeclaration(file->service(i), h_p);
+
+        const std::unique_ptr<io::ZeroCopyOutputStream> cpp_out(context->Open(base_filename + "Server.cpp"));
+        io::Printer cpp_p(cpp_out.get(), '$');
+        cpp_p.Print({{"b", base_filename}}, "#include \"$b$Server.h\"\n\n");
+        for (int i = 0; i < file->service_count(); i++) GenerateServerDefinition(file->service(i), cpp_p);
+    }
+
+    static void GenerateLoopbackDeclaration(const ServiceDescriptor* service, io::Printer& printer) {
+        printer.Print({{"svc", std::string(service->name())}, {"fn", std::string(service->full_name())}, {"ps", GetProtoCppType(service)}},
+            "/**\n"
+            " * Fake $fn$ for benchmarks and tests. Unary methods answer with their canned response\n"
+            " * unless a handler is set; server streams write the canned response ResponseCount times; client\n"
+            " * streams drain and answer once; bidi streams echo when the types match, else reply canned.\n"
+            " */\n"
+            "class F$svc$Loopback final : public $ps$::CallbackService {\n"
+            "public:\n");
+        printer.Indent();
+        for (int i = 0; i < service->method_count(); i++) {
+            const MethodDescriptor* method = service->method(i);
+            const auto vars = GetMethodVars(method);
+            printer.Print(vars, "$pres$ $m$Response;\n");
+            if (IsUnary(method)) printer.Print(vars, "std::function<grpc::Status(const $preq$&, $pres$&)> $m$Handler;\n");
+            else if (method->server_streaming() && !method->client_streaming()) printer.Print(vars, "int32 $m$ResponseCount = 1;\n");
+        }
+        printer.Print("\n");
+        for (int i = 0; i < service->method_count(); i++) {
+            const MethodDescriptor* method = service->method(i);
+            const auto vars = GetMethodVars(method);
+            if (IsUnary(method)) printer.Print(vars,
+                "grpc::ServerUnaryReactor* $m$(grpc::CallbackServerContext* Context, const $preq$* Request, $pres$* Response) override;\n");
+            else if (method->client_streaming() && method->server_streaming()) printer.Print(vars,
+                "grpc::ServerBidiReactor<$preq$, $pres$>* $m$(grpc::CallbackServerContext* Context) override;\n");
+            else if (method->server_streaming()) printer.Print(vars,
+                "grpc::ServerWriteReactor<$pres$>* $m$(grpc::CallbackServerContext* Context, const $preq$* Request) override;\n");
+            else printer.Print(vars,
+                "grpc::ServerReadReactor<$preq$>* $m$(grpc::CallbackServerContext* Context, $pres$* Response) override;\n");
+        }
+        printer.Outdent();
+        printer.Print({{"svc", std::string(service->name())}},
+            "};\n\n"
+            "/** Times every unary method of the service through F$svc$Client against the given loopback server. */\n"
+            "TArray<UnrealGrpc::FLoopbackMethodResult> Run$svc$LoopbackBenchmark(F$svc$Loopback& Service, const UnrealGrpc::FLoopbackBenchmarkConfig& Config = {});\n\n");
+        if (IsRecorded(service)) {
+            printer.Print({{"svc", std::string(service->name())}},
+                "/**\n"
+                " * Replays the unary calls of an FTrafficRecorder recording through F$svc$Client at their recorded\n"
+                " * pace, against a loopback server that answers with the recorded responses. Empty if the file isn't a recording.\n"
+                " */\n"
+                "TArray<UnrealGrpc::FReplayMethodResult> Replay$svc$Recording(const std::string& Path, const UnrealGrpc::FTrafficReplayConfig& Config = {});\n\n");
+        }
+    }
+
+    static void GenerateLoopbackDefinition(const ServiceDescriptor* service, const GeneratorOptions& options, io::Printer& printer) {
+        const std::string svc = std::string(service->name());
+        for (int i = 0; i < service->method_count(); i++) {
+            const MethodDescriptor* method = service->method(i);
+            const auto vars = GetMethodVars(method);
+            if (IsUnary(method)) printer.Print(vars,
+                "grpc::ServerUnaryReactor* F$svc$Loopback::$m$(grpc::CallbackServerContext* Context, const $preq$* Request, $pres$* Response) {\n"
+                "  grpc::ServerUnaryReactor* Reactor = Context->DefaultReactor();\n"
+                "  if ($m$Handler) {\n"
+                "    Reactor->Finish($m$Handler(*Request, *Response));\n"
+                "  } else {\n"
+                "    *Response = $m$Response;\n"
+                "    Reactor->Finish(grpc::Status::OK);\n"
+                "  }\n"
+                "  return Reactor;\n"
+                "}\n\n");
+            else if (method->client_streaming() && method->server_streaming()) printer.Print(vars,
+                "grpc::ServerBidiReactor<$preq$, $pres$>* F$svc$Loopback::$m$(grpc::CallbackServerContext* Context) {\n"
+                "  return new UnrealGrpc::TLoopbackBidi<$preq$, $pres$>($m$Response);\n"
+                "}\n\n");
+            else if (method->server_streaming()) printer.Print(vars,
+                "grpc::ServerWriteReactor<$pres$>* F$svc$Loopback::$m$(grpc::CallbackServerContext* Context, const $preq$* Request) {\n"
+                "  return new UnrealGrpc::TLoopbackWriter<$pres$>($m$Response, $m$ResponseCount);\n"
+                "}\n\n");
+            else printer.Print(vars,
+                "grpc::ServerReadReactor<$preq$>* F$svc$Loopback::$m$(grpc::CallbackServerContext* Context, $pres$* Response) {\n"
+                "  return new UnrealGrpc::TLoopbackReader<$preq$, $pres$>(Response, $m$Response);\n"
+                "}\n\n");
+        }
+
+        printer.Print({{"svc", svc}},
+            "TArray<UnrealGrpc::FLoopbackMethodResult> Run$svc$LoopbackBenchmark(F$svc$Loopback& Service, const UnrealGrpc::FLoopbackBenchmarkConfig& Config) {\n");
+        printer.Indent();
+        printer.Print({{"svc", svc}},
+            "TArray<UnrealGrpc::FLoopbackMethodResult> Results;\n"
+            "UnrealGrpc::FLoopbackServer Server(Service, Config.Transport);\n"
+            "if (!Server.IsRunning()) return Results;\n"
+            "F$svc$Client Client(Server.CreatePool(Config.NumChannels));\n");
+        for (int i = 0; i < service->method_count(); i++) {
+            const MethodDescriptor* method = service->method(i);
+            if (!IsUnary(method)) continue;
+            auto vars = GetMethodVars(method);
+            vars["api"] = options.bCallbackClients ? "callback" : "cq";
+            printer.Print(vars,
+                "{\n"
+                "  UnrealGrpc::FLoopbackMethodResult Result;\n"
+                "  Result.Method = \"$m$\";\n"
+                "  Result.ClientApi = \"$api$\";\n"
+                "  const $req$ Request{};\n"
+                "  $res$ Response;\n"
+                "  Result.Call = UnrealGrpc::MeasureLatency(Config, [&] { return Client.$m$(Request, Response).ok(); }, &Result.FailedCalls);\n"
+                "  const double CpuStartUs = UnrealGrpc::GetProcessCpuUs();\n"
+                "  Result.AsyncCall = UnrealGrpc::MeasureLatency(Config, [&] {\n"
+                "    std::promise<bool> Done;\n"
+                "    Client.$m$Async(Request, [&Done](const grpc::Status& Status, const $res$&) { Done.set_value(Status.ok()); });\n"
+                "    return Done.get_future().get();\n"
+                "  }, &Result.FailedCalls);\n"
+                "  Result.AsyncCpuUs = (UnrealGrpc::GetProcessCpuUs() - CpuStartUs) / FMath::Max(Config.WarmupIterations + Config.Iterations, 1);\n"
+                "  Result.Conversion = UnrealGrpc::MeasureLatency(Config, [&] {\n"
+                "    $preq$ ProtoRequest;\n"
+                "    $cn$::ToProto(Request, ProtoRequest);\n"
+                "    Response = $cn$::Convert(Service.$m$Response);\n"
+                "    return true;\n"
+                "  });\n"
+                "  $preq$ ProtoRequest;\n"
+                "  $cn$::ToProto(Request, ProtoRequest);\n"
+                "  UnrealGrpc::MeasureSerialization(Config, ProtoRequest, Result);\n"
+                "  UnrealGrpc::MeasureParsing(Config, Service.$m$Response, Result);\n"
+                "  Results.Add(MoveTemp(Result));\n"
+                "}\n");
+        }
+        printer.Print("return Results;\n");
+        printer.Outdent();
+        printer.Print("}\n\n");
+
+        //lets CI run the benchmark headless, e.g. -ExecCmds="Automation RunTests UnrealGrpc.Loopback"
+        printer.Print({{"svc", svc}, {"fn", std::string(service->full_name())}},
+            "#if WITH_DEV_AUTOMATION_TESTS\n"
+            "IMPLEMENT_SIMPLE_AUTOMATION_TEST(F$svc$LoopbackBenchmarkTest, \"UnrealGrpc.Loopback.$fn$\", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::PerfFilter)\n"
+            "bool F$svc$LoopbackBenchmarkTest::RunTest(const FString& Parameters) {\n"
+            "  F$svc$Loopback Service;\n"
+            "  for (const UnrealGrpc::FLoopbackMethodResult& Result : Run$svc$LoopbackBenchmark(Service)) {\n"
+            "    AddInfo(FString::Printf(TEXT(\"%s: call p50 %.1fus p99 %.1fus, %s async p50 %.1fus p99 %.1fus cpu %.1fus, conversion p50 %.1fus p99 %.1fus, \"\n"
+            "      \"serialize p50 %.2fus slab p50 %.2fus (%.1f allocations per 1000), parse flattened p50 %.2fus in place p50 %.2fus (%.2f and %.2f bytes copied per byte)\"),\n"
+            "      UTF8_TO_TCHAR(Result.Method.c_str()), Result.Call.P50Us, Result.Call.P99Us, UTF8_TO_TCHAR(Result.ClientApi.c_str()),\n"
+            "      Result.AsyncCall.P50Us, Result.AsyncCall.P99Us, Result.AsyncCpuUs, Result.Conversion.P50Us, Result.Conversion.P99Us,\n"
+            "      Result.Serialize.P50Us, Result.SlabSerialize.P50Us, Result.SlabAllocationsPerThousand, Result.FlatParse.P50Us, Result.SliceParse.P50Us,\n"
+            "      Result.FlatParseCopiesPerByte, Result.SliceParseCopiesPerByte));\n"
+            "    TestEqual(TEXT(\"Failed calls\"), Result.FailedCalls, 0);\n"
+            "  }\n"
+            "  return true;\n"
+            "}\n"
+            "#endif\n\n");
+        if (IsRecorded(service)) PrintReplay(service, printer);
+    }
+
+    //Replay<Service>Recording and the automation test that runs it on a recording named on the command line
+    static void PrintReplay(const ServiceDescriptor* service, io::Printer& printer) {
+        const std::string svc = std::string(service->name());
+        std::vector<const MethodDescriptor*> methods;
+        for (int i = 0; i < service->method_count(); i++) {
+            if (IsUnary(service->method(i))) methods.push_back(service->method(i));
+        }
+        printer.Print({{"svc", svc}},
+            "TArray<UnrealGrpc::FReplayMethodResult> Replay$svc$Recording(const std::string& Path, const UnrealGrpc::FTrafficReplayConfig& Config) {\n");
+        printer.Indent();
+        printer.Print({{"svc", svc}},
+            "TArray<UnrealGrpc::FReplayMethodResult> Results;\n"
+            "std::vector<UnrealGrpc::FRecordedCall> Calls;\n"
+            "if (!UnrealGrpc::LoadRecording(Path, Calls)) return Results;\n"
+            "UnrealGrpc::FTrafficReplay Replay(Calls, {\n");
+        for (const MethodDescriptor* method : methods) printer.Print(GetMethodVars(method), "  \"$path$\",\n");
+        printer.Print({{"svc", svc}},
+            "});\n"
+            "F$svc$Loopback Service;\n");
+        for (size_t i = 0; i < methods.size(); i++) {
+            auto vars = GetMethodVars(methods[i]);
+            vars["i"] = std::to_string(i);
+            printer.Print(vars,
+                "Service.$m$Handler = [&Replay](const $preq$& Request, $pres$& Response) { return Replay.Answer($i$, Request, Response); };\n");
+        }
+        printer.Print({{"svc", svc}},
+            "UnrealGrpc::FLoopbackServer Server(Service, Config.Transport);\n"
+            "if (!Server.IsRunning()) return Results;\n"
+            "F$svc$Client Client(Server.CreatePool(Config.NumChannels));\n"
+            "//each call goes out as the USTRUCT the game would have sent, through the current converters\n"
+            "for (UnrealGrpc::FReplayMethodResult& Result : Replay.Run(Config.Speed,\n"
+            "  [&](const UnrealGrpc::FRecordedCall& Call, int32 Method, UnrealGrpc::FTrafficReplay::FCompletion Done) {\n"
+            "    switch (Method) {\n");
+        for (size_t i = 0; i < methods.size(); i++) {
+            auto vars = GetMethodVars(methods[i]);
+            vars["i"] = std::to_string(i);
+            printer.Print(vars,
+                "    case $i$: {\n"
+                "      $preq$ ProtoRequest;\n"
+                "      $pres$ ProtoResponse;\n"
+                "      if (!ProtoRequest.ParseFromString(Call.Request) || !ProtoResponse.ParseFromString(Call.Response)) return false;\n"
+                "      const $req$ Request = $cn$::Convert(ProtoRequest);\n"
+                "      Replay.TimeConversion(Method, [&] {\n"
+                "        $preq$ Converted;\n"
+                "        $cn$::ToProto(Request, Converted);\n"
+                "        const $res$ Response = $cn$::Convert(ProtoResponse);\n"
+                "      });\n"
+                "      Client.$m$Async(Request, [Done](const grpc::Status& Status, const $res$&) { Done(Status); });\n"
+                "      return true;\n"
+                "    }\n");
+        }
+        printer.Print(
+            "    default:\n"
+            "      return false;\n"
+            "    }\n"
+            "  })) {\n"
+            "  Results.Add(MoveTemp(Result));\n"
+            "}\n"
+            "return Results;\n");
+        printer.Outdent();
+        printer.Print("}\n\n");
+
+        //e.g. -ExecCmds="Automation RunTests UnrealGrpc.Replay" -GrpcReplay=Saved/Profile.rec -GrpcReplaySpeed=4
+        printer.Print({{"svc", svc}, {"fn", std::string(service->full_name())}},
+            "#if WITH_DEV_AUTOMATION_TESTS\n"
+            "IMPLEMENT_SIMPLE_AUTOMATION_TEST(F$svc$ReplayTest, \"UnrealGrpc.Replay.$fn$\", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::PerfFilter)\n"
+            "bool F$svc$ReplayTest::RunTest(const FString& Parameters) {\n"
+            "  FString Path;\n"
+            "  if (!FParse::Value(FCommandLine::Get(), TEXT(\"GrpcReplay=\"), Path)) {\n"
+            "    AddInfo(TEXT(\"Pass -GrpcReplay=<recording> to replay it\"));\n"
+            "    return true;\n"
+            "  }\n"
+            "  UnrealGrpc::FTrafficReplayConfig Config;\n"
+            "  FParse::Value(FCommandLine::Get(), TEXT(\"GrpcReplaySpeed=\"), Config.Speed);\n"
+            "  const TArray<UnrealGrpc::FReplayMethodResult> Results = Replay$svc$Recording(TCHAR_TO_UTF8(*Path), Config);\n"
+            "  TestTrue(TEXT(\"Recording loaded\"), Results.Num() > 0);\n"
+            "  for (const UnrealGrpc::FReplayMethodResult& Result : Results) {\n"
+            "    AddInfo(FString::Printf(TEXT(\"%s: %d calls, %d skipped, call p50 %.1fus p99 %.1fus max %.1fus, conversion p50 %.1fus p99 %.1fus\"),\n"
+            "      UTF8_TO_TCHAR(Result.Method.c_str()), Result.Calls, Result.Skipped, Result.Call.P50Us, Result.Call.P99Us, Result.Call.MaxUs,\n"
+            "      Result.Conversion.P50Us, Result.Conversion.P99Us));\n"
+            "    TestEqual(TEXT(\"Status mismatches\"), Result.StatusMismatches, 0);\n"
+            "  }\n"
+            "  return true;\n"
+            "}\n"
+            "#endif\n\n");
+    }
+
+    static void GenerateLoopback(const FileDescriptor* file, const std::string& base_filename, const GeneratorOptions& options, GeneratorContext* context) {
+        const std::unique_ptr<io::ZeroCopyOutputStream> h_out(context->Open(base_filename + "Loopback.h"));
+        io::Printer h_p(h_out.get(), '$');
+        h_p.Print({{"b", base_filename}, {"lh", kLoopbackHeader}},
+            "#pragma once\n#include \"CoreMinimal.h\"\n#include \"$lh$\"\n#include \"$b$Client.h\"\n\n");
+        for (int i = 0; i < file->service_count(); i++) GenerateLoopbackDeclaration(file->service(i), h_p);
+
+        const std::unique_ptr<io::ZeroCopyOutputStream> cpp_out(context->Open(base_filename + "Loopback.cpp"));
+        io::Printer cpp_p(cpp_out.get(), '$');
+        bool any_recorded = false;
+        for (int i = 0; i < file->service_count(); i++) any_recorded |= IsRecorded(file->service(i));
+        cpp_p.Print({{"b", base_filename}, {"replay", any_recorded ? "#include \"Misc/CommandLine.h\"\n#include \"Misc/Parse.h\"\n" : ""}},
+            "#include \"$b$Loopback.h\"\n#if WITH_DEV_AUTOMATION_TESTS\n#include \"Misc/AutomationTest.h\"\n#include \"UObject/UnrealType.h\"\n$replay$#endif\n\n");
+        for (int i = 0; i < file->service_count(); i++) GenerateLoopbackDefinition(file->service(i), options, cpp_p);
+        PrintReflectionCost(file, base_filename, cpp_p);
+    }
+
+    //what each message costs UE's reflection, to decide which hot-path messages to make plain_struct. UHT
+    //time and the generated .gen.cpp grow with the reflected structs and properties; anything that walks a
+    //struct by reflection (GC reference collection, SaveGame, replication, details panels) visits every property
+    static void PrintReflectionCost(const FileDescriptor* file, const std::string& base_filename, io::Printer& printer) {
+        printer.Print({{"b", base_filename}, {"fn", file->package().empty() ? base_filename : std::string(file->package())}},
+            "#if WITH_DEV_AUTOMATION_TESTS\n"
+            "template <typename T>\n"
+            "static void Measure$b$Reflection(FAutomationTestBase& Test, const TCHAR* Name, int32& OutStructs, int32& OutProperties) {\n"
+            "  UScriptStruct* Struct = T::StaticStruct();\n"
+            "  int32 Properties = 0;\n"
+            "  bool bObjectReferences = false;\n"
+            "  for (TFieldIterator<FProperty> It(Struct); It; ++It) {\n"
+            "    TArray<const FStructProperty*> Encountered;\n"
+            "    bObjectReferences |= It->ContainsObjectReference(Encountered);\n"
+            "    Properties++;\n"
+            "  }\n"
+            "  //containers of a default instance are empty, so this is the cost of the struct's own properties\n"
+            "  const T Value{};\n"
+            "  constexpr int32 Walks = 10000;\n"
+            "  int32 Visited = 0;\n"
+            "  const double Start = FPlatformTime::Seconds();\n"
+            "  for (int32 i = 0; i < Walks; i++) {\n"
+            "    for (TPropertyValueIterator<const FProperty> It(Struct, &Value); It; ++It) Visited++;\n"
+            "  }\n"
+            "  const double WalkNs = (FPlatformTime::Seconds() - Start) * 1e9 / Walks;\n"
+            "  Test.AddInfo(FString::Printf(TEXT(\"F%s: %d reflected properties over %d bytes, %s, %.1fns to walk by reflection (%d values)\"), Name, Properties,\n"
+            "    Struct->GetStructureSize(), bObjectReferences ? TEXT(\"scanned by GC\") : TEXT(\"no object references\"), WalkNs, Visited / Walks));\n"
+            "  OutStructs++;\n"
+            "  OutProperties += Properties;\n"
+            "}\n\n"
+            "IMPLEMENT_SIMPLE_AUTOMATION_TEST(F$b$ReflectionTest, \"UnrealGrpc.Reflection.$fn$\", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::PerfFilter)\n"
+            "bool F$b$ReflectionTest::RunTest(const FString& Parameters) {\n"
+            "  int32 Structs = 0;\n"
+            "  int32 Properties = 0;\n");
+        int messages = 0;
+        for (int i = 0; i < file->message_type_count(); i++) {
+            const Descriptor* msg = file->message_type(i);
+            if (msg->options().map_entry()) continue;
+            messages++;
+            if (IsPlainStruct(msg)) printer.Print({{"n", std::string(msg->name())}},
+                "  AddInfo(TEXT(\"F$n$: plain C++ struct, nothing reflected\"));\n");
+            else printer.Print({{"n", std::string(msg->name())}, {"b", base_filename}},
+                "  Measure$b$Reflection<F$n$>(*this, TEXT(\"$n$\"), Structs, Properties);\n");
+        }
+        printer.Print({{"count", std::to_string(messages)}},
+            "  AddInfo(FString::Printf(TEXT(\"%d of $count$ messages reflected, %d properties for UHT to process\"), Structs, Properties));\n"
+            "  return true;\n"
+            "}\n"
+            "#endif\n");
+    }
+
+    //fields a TWireCodec reads and writes exactly. Types the struct falls back to FString for, such as bytes
+    //or fixed32, would not round-trip, and nested message types have no struct of their own
+    static bool IsWireFieldSupported(const FieldDescriptor* field, std::set<const Descriptor*>& visiting) {
+        switch (field->type()) {
+        case FieldDescriptor::TYPE_DOUBLE: case FieldDescriptor::TYPE_FLOAT: case FieldDescriptor::TYPE_INT64:
+        case FieldDescriptor::TYPE_UINT64: case FieldDescriptor::TYPE_INT32: case FieldDescriptor::TYPE_BOOL:
+        case FieldDescriptor::TYPE_STRING: case FieldDescriptor::TYPE_ENUM:
+            return true;
+        case FieldDescriptor::TYPE_MESSAGE:
+            return IsWireCodecSupported(field->message_type(), visiting);
+        default:
+            return false;
+        }
+    }
+
+    static bool IsWireCodecSupported(const Descriptor* msg, std::set<const Descriptor*>& visiting) {
+        if (msg->containing_type() != nullptr) return false;
+        //a message that contains itself is supported when the rest of it is
+        if (!visiting.insert(msg).second) return true;
+        for (int i = 0; i < msg->field_count(); i++) {
+            const FieldDescriptor* f = msg->field(i);
+            if (f->containing_oneof() != nullptr && f->real_containing_oneof() == nullptr) continue;
+            if (f->is_map()) {
+                const Descriptor* entry = f->message_type();
+                if (!IsWireFieldSupported(entry->FindFieldByName("key"), visiting) || !IsWireFieldSupported(entry->FindFieldByName("value"), visiting)) return false;
+            } else if (!IsWireFieldSupported(f, visiting)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    static bool IsWireCodecSupported(const Descriptor* msg) {
+        std::set<const Descriptor*> visiting;
+        return IsWireCodecSupported(msg, visiting);
+    }
+
+    static bool IsDirectMethod(const MethodDescriptor* method) {
+        return IsUnary(method) && IsWireCodecSupported(method->input_type()) && IsWireCodecSupported(method->output_type());
+    }
+
+    static uint32_t GetWireType(const FieldDescriptor* field) {
+        switch (field->type()) {
+        case FieldDescriptor::TYPE_DOUBLE: return 1;
+        case FieldDescriptor::TYPE_FLOAT: return 5;
+        case FieldDescriptor::TYPE_STRING: case FieldDescriptor::TYPE_MESSAGE: return 2;
+        default: return 0;
+        }
+    }
+
+    //tags are emitted as literals, so the codec does no tag arithmetic at run time
+    static std::string GetWireTag(int number, uint32_t wire_type) {
+        return std::to_string(static_cast<uint32_t>(number) << 3 | wire_type);
+    }
+
+    static std::string GetWireTagSize(int number, uint32_t wire_type) {
+        size_t size = 1;
+        for (uint32_t tag = static_cast<uint32_t>(number) << 3 | wire_type; tag >= 0x80; tag >>= 7) size++;
+        return std::to_string(size);
+    }
+
+    //size and write calls for one value of field, tagged with number
+    static std::string GetWireSizeCall(const FieldDescriptor* field, int number, const std::string& value) {
+        const std::string tag_size = GetWireTagSize(number, GetWireType(field));
+        if (field->type() == FieldDescriptor::TYPE_STRING) return "Wire::StringSize(" + tag_size + ", *" + value + ", " + value + ".Len(), Sizes)";
+        if (field->type() == FieldDescriptor::TYPE_MESSAGE) return "Wire::MessageSize(" + tag_size + ", " + value + ", Sizes)";
+        return "Wire::ScalarSize(" + tag_size + ", " + value + ")";
+    }
+
+    static std::string GetWireWriteCall(const FieldDescriptor* field, int number, const std::string& value) {
+        const std::string tag = GetWireTag(number, GetWireType(field));
+        if (field->type() == FieldDescriptor::TYPE_STRING) return "Wire::WriteString(" + tag + ", *" + value + ", " + value + ".Len(), Sizes, Out)";
+        if (field->type() == FieldDescriptor::TYPE_MESSAGE) return "Wire::WriteMessage(" + tag + ", " + value + ", Sizes, Out)";
+        return "Wire::WriteScalar(" + tag + ", " + value + ", Out)";
+    }
+
+    static std::string GetWireReadCall(const FieldDescriptor* field, const std::string& reader, const std::string& wire_type, const std::string& target) {
+        if (field->type() == FieldDescriptor::TYPE_STRING) return "ReadWireString(" + reader + ", " + wire_type + ", " + target + ")";
+        if (field->type() == FieldDescriptor::TYPE_MESSAGE) return reader + ".ReadStruct(" + wire_type + ", " + target + ")";
+        return reader + ".ReadValue(" + wire_type + ", " + target + ")";
+    }
+
+    //one field of TWireCodec::Size or Write. Both walk the fields in the same order, so Write finds
+    //the lengths Size recorded in the order it needs them
+    static void PrintWireField(const Descriptor* msg, const FieldDescriptor* f, bool size, io::Printer& printer) {
+        const std::string un = ToPascalCase(f->name());
+        std::map<std::string, std::string> vars = {{"f", "In." + un}};
+        const auto statement = [&](const std::string& value) {
+            return size ? "Total += " + GetWireSizeCall(f, f->number(), value) : "Out = " + GetWireWriteCall(f, f->number(), value);
+        };
+        if (f->is_map()) {
+            const FieldDescriptor* kf = f->message_type()->FindFieldByName("key");
+            const FieldDescriptor* vf = f->message_type()->FindFieldByName("value");
+            vars["ts"] = GetWireTagSize(f->number(), 2);
+            vars["tag"] = GetWireTag(f->number(), 2);
+            //protobuf writes both halves of an entry even when they are defaults
+            if (size) {
+                vars["k"] = GetWireSizeCall(kf, kf->number(), "P.Key");
+                vars["v"] = GetWireSizeCall(vf, vf->number(), "P.Value");
+                //separate statements: key and value record their lengths in order
+                printer.Print(vars,
+                    "for (const auto& P : $f$) {\n"
+                    "  const size_t Slot = Sizes.Reserve();\n"
+                    "  size_t Entry = $k$;\n"
+                    "  Entry += $v$;\n"
+                    "  Total += $ts$ + Sizes.Set(Slot, Entry);\n"
+                    "}\n");
+            } else {
+                vars["k"] = GetWireWriteCall(kf, kf->number(), "P.Key");
+                vars["v"] = GetWireWriteCall(vf, vf->number(), "P.Value");
+                printer.Print(vars,
+                    "for (const auto& P : $f$) {\n"
+                    "  Out = Wire::WriteVarint(Sizes.Next(), Wire::WriteVarint($tag$, Out));\n"
+                    "  Out = $k$;\n"
+                    "  Out = $v$;\n"
+                    "}\n");
+            }
+        } else if (f->is_packed()) {
+            vars["ts"] = GetWireTagSize(f->number(), 2);
+            vars["tag"] = GetWireTag(f->number(), 2);
+            if (size) printer.Print(vars, "if ($f$.Num()) Total += Wire::PackedSize($ts$, $f$, Sizes);\n");
+            else printer.Print(vars, "if ($f$.Num()) Out = Wire::WritePacked($tag$, $f$, Sizes, Out);\n");
+        } else if (f->is_repeated()) {
+            vars["s"] = statement("E");
+            printer.Print(vars, "for (const auto& E : $f$) $s$;\n");
+        } else if (f->has_presence()) {
+            vars["s"] = statement(vars["f"] + ".GetValue()");
+            //a oneof member is only on the wire while the case enum selects it
+            if (const OneofDescriptor* oneof = f->real_containing_oneof()) {
+                vars["t"] = ToPascalCase(oneof->name());
+                vars["et"] = std::string(msg->name()) + vars["t"];
+                vars["un"] = un;
+                printer.Print(vars, "if (In.$t$Type == E$et$Type::$un$ && $f$.IsSet()) $s$;\n");
+            } else {
+                printer.Print(vars, "if ($f$.IsSet()) $s$;\n");
+            }
+        } else {
+            vars["s"] = statement(vars["f"]);
+            if (f->type() == FieldDescriptor::TYPE_STRING) printer.Print(vars, "if (!$f$.IsEmpty()) $s$;\n");
+            else printer.Print(vars, "if (!Wire::IsDefault($f$)) $s$;\n");
+        }
+    }
+
+    //one case of TWireCodec::Read, merging the field into Out as protobuf's parser would
+    static void PrintWireReadCase(const Descriptor* msg, const FieldDescriptor* f, io::Printer& printer) {
+        const std::string un = ToPascalCase(f->name());
+        std::map<std::string, std::string> vars = {{"num", std::to_string(f->number())}, {"f", "Out." + un}};
+        if (f->is_map()) {
+            const FieldDescriptor* kf = f->message_type()->FindFieldByName("key");
+            const FieldDescriptor* vf = f->message_type()->FindFieldByName("value");
+            vars["kt"] = GetBaseUEType(kf);
+            vars["vt"] = GetBaseUEType(vf);
+            vars["rk"] = GetWireReadCall(kf, "Entry", "EntryWireType", "Key");
+            vars["rv"] = GetWireReadCall(vf, "Entry", "EntryWireType", "Value");
+            printer.Print(vars,
+                "case $num$: {\n"
+                "  FWireReader Entry;\n"
+                "  if (!Reader.ReadMessage(WireType, Entry)) return false;\n"
+                "  $kt$ Key{};\n"
+                "  $vt$ Value{};\n"
+                "  uint32 EntryField;\n"
+                "  uint32 EntryWireType;\n"
+                "  while (Entry.ReadTag(EntryField, EntryWireType)) {\n"
+                "    if (EntryField == 1 ? !$rk$ : EntryField == 2 ? !$rv$ : !Entry.Skip(EntryWireType)) return false;\n"
+                "  }\n"
+                "  if (!Entry.IsComplete()) return false;\n"
+                "  $f$.Add(MoveTemp(Key), MoveTemp(Value));\n"
+                "  break;\n"
+                "}\n");
+            return;
+        }
+        printer.Print(vars, "case $num$:\n");
+        printer.Indent();
+        if (f->is_repeated()) {
+            if (f->type() == FieldDescriptor::TYPE_STRING || f->type() == FieldDescriptor::TYPE_MESSAGE) {
+                printer.Print("if (!$r$) return false;\n", "r", GetWireReadCall(f, "Reader", "WireType", vars["f"] + ".AddDefaulted_GetRef()"));
+            } else {
+                printer.Print(vars, "if (!Reader.ReadRepeated(WireType, $f$)) return false;\n");
+            }
+        } else if (f->has_presence()) {
+            if (const OneofDescriptor* oneof = f->real_containing_oneof()) {
+                vars["t"] = ToPascalCase(oneof->name());
+                vars["et"] = std::string(msg->name()) + vars["t"];
+                vars["un"] = un;
+                //the last member on the wire wins, as it does in protobuf
+                printer.Print(vars, "if (Out.$t$Type != E$et$Type::$un$) {\n");
+                for (int i = 0; i < oneof->field_count(); i++) {
+                    if (oneof->field(i) != f) printer.Print("  Out.$s$.Reset();\n", "s", ToPascalCase(oneof->field(i)->name()));
+                }
+                printer.Print(vars,
+                    "  Out.$t$Type = E$et$Type::$un$;\n"
+                    "}\n");
+            }
+            printer.Print(vars, "if (!$f$.IsSet()) $f$.Emplace();\n");
+            printer.Print("if (!$r$) return false;\n", "r", GetWireReadCall(f, "Reader", "WireType", vars["f"] + ".GetValue()"));
+        } else {
+            printer.Print("if (!$r$) return false;\n", "r", GetWireReadCall(f, "Reader", "WireType", vars["f"]));
+        }
+        printer.Print("break;\n");
+        printer.Outdent();
+    }
+
+    static void GenerateWireCodec(const Descriptor* msg, io::Printer& h_p, io::Printer& cpp_p) {
+        const std::string msg_name(msg->name());
+        h_p.Print({{"n", msg_name}},
+            "template <>\n"
+            "struct TWireCodec<F$n$> {\n"
+            "  static size_t Size(const F$n$& In, FWireSizes& Sizes);\n"
+            "  static uint8* Write(const F$n$& In, FWireSizes& Sizes, uint8* Out);\n"
+            "  static bool Read(FWireReader& Reader, F$n$& Out);\n"
+            "};\n\n");
+
+        std::vector<const FieldDescriptor*> fields;
+        for (int i = 0; i < msg->field_count(); i++) {
+            const FieldDescriptor* f = msg->field(i);
+            if (f->containing_oneof() != nullptr && f->real_containing_oneof() == nullptr) continue;
+            fields.push_back(f);
+        }
+        //protobuf writes fields in number order, which keeps the bytes identical to its own
+        std::ranges::sort(fields, {}, &FieldDescriptor::number);
+
+        cpp_p.Print({{"n", msg_name}}, "size_t TWireCodec<F$n$>::Size(const F$n$& In, FWireSizes& Sizes) {\n");
+        cpp_p.Indent();
+        cpp_p.Print("size_t Total = 0;\n");
+        for (const FieldDescriptor* f : fields) PrintWireField(msg, f, true, cpp_p);
+        cpp_p.Print("return Total;\n");
+        cpp_p.Outdent();
+        cpp_p.Print({{"n", msg_name}}, "}\n\nuint8* TWireCodec<F$n$>::Write(const F$n$& In, FWireSizes& Sizes, uint8* Out) {\n");
+        cpp_p.Indent();
+        for (const FieldDescriptor* f : fields) PrintWireField(msg, f, false, cpp_p);
+        cpp_p.Print("return Out;\n");
+        cpp_p.Outdent();
+        cpp_p.Print({{"n", msg_name}},
+            "}\n\n"
+            "bool TWireCodec<F$n$>::Read(FWireReader& Reader, F$n$& Out) {\n"
+            "  uint32 Field;\n"
+            "  uint32 WireType;\n"
+            "  while (Reader.ReadTag(Field, WireType)) {\n"
+            "    switch (Field) {\n");
+        cpp_p.Indent();
+        cpp_p.Indent();
+        for (const FieldDescriptor* f : fields) PrintWireReadCase(msg, f, cpp_p);
+        //fields the struct has no member for are dropped, as protobuf would keep them as unknown
+        cpp_p.Print(
+            "default:\n"
+            "  if (!Reader.Skip(WireType)) return false;\n"
+            "  break;\n");
+        cpp_p.Outdent();
+        cpp_p.Outdent();
+        cpp_p.Print(
+            "    }\n"
+            "  }\n"
+            "  return Reader.IsComplete();\n"
+            "}\n\n");
+    }
+
+    //serialization headers of other files whose messages the codecs here nest
+    static std::set<std::string> GetWireCodecDependencies(const FileDescriptor* file) {
+        std::set<std::string> headers;
+        for (int i = 0; i < file->message_type_count(); i++) {
+            const Descriptor* msg = file->message_type(i);
+            if (msg->options().map_entry() || !IsWireCodecSupported(msg)) continue;
+            for (int j = 0; j < msg->field_count(); j++) {
+                const FieldDescriptor* f = msg->field(j);
+                if (f->type() != FieldDescriptor::TYPE_MESSAGE) continue;
+                const FieldDescriptor* target = f->is_map() ? f->message_type()->FindFieldByName("value") : f;
+                if (target->type() == FieldDescriptor::TYPE_MESSAGE && target->message_type()->file() != file) {
+                    headers.insert(GetBaseFilename(target->message_type()->file()) + "Serialization.h");
+                }
+            }
+        }
+        return headers;
+    }
+
+    static void GenerateSerialization(const FileDescriptor* file, const std::string& base_filename, const std::string& proto_ns, GeneratorContext* context) {
+        const std::unique_ptr<io::ZeroCopyOutputStream> h_out(context->Open(base_filename + "Serialization.h"));
+        io::Printer h_p(h_out.get(), '$');
+        h_p.Print({{"b", base_filename}, {"sh", kSerializationHeader}, {"wh", kWireCodecHeader}},
+            "#pragma once\n#include \"CoreMinimal.h\"\n#include \"$sh$\"\n#include \"$wh$\"\n#include \"$b$Converter.h\"\n");
+        for (const auto& header : GetWireCodecDependencies(file)) h_p.Print("#include \"$h$\"\n", "h", header);
+        h_p.Print("\n"
+            "namespace UnrealGrpc {\n\n"
+            "//Serialize converts In and serializes it into one exact-size slice from Slab; Parse reads the\n"
+            "//received slices in place and converts the result into Out\n");
+        const std::unique_ptr<io::ZeroCopyOutputStream> cpp_out(context->Open(base_filename + "Serialization.cpp"));
+        io::Printer cpp_p(cpp_out.get(), '$');
+        cpp_p.Print({{"b", base_filename}}, "#include \"$b$Serialization.h\"\n\nnamespace UnrealGrpc {\n\n");
+        std::vector<const Descriptor*> codecs;
+        for (int i = 0; i < file->message_type_count(); i++) {
+            const Descriptor* msg = file->message_type(i);
+            if (msg->options().map_entry()) continue;
+            if (IsWireCodecSupported(msg)) codecs.push_back(msg);
+            const std::map<std::string, std::string> vars = {{"n", std::string(msg->name())}, {"ns", proto_ns}, {"cn", kConverterClassName.data()}};
+            h_p.Print(vars,
+                "void SerializeToByteBuffer(const F$n$& In, FSerializationSlab& Slab, grpc::ByteBuffer& Out);\n"
+                "bool ParseFromByteBuffer(grpc::ByteBuffer& Buffer, F$n$& Out);\n");
+            cpp_p.Print(vars,
+                "void SerializeToByteBuffer(const F$n$& In, FSerializationSlab& Slab, grpc::ByteBuffer& Out) {\n"
+                "  $ns$$n$ Proto;\n"
+                "  $cn$::ToProto(In, Proto);\n"
+                "  SerializeToByteBuffer(Proto, Slab, Out);\n"
+                "}\n\n"
+                "bool ParseFromByteBuffer(grpc::ByteBuffer& Buffer, F$n$& Out) {\n"
+                "  $ns$$n$ Proto;\n"
+                "  if (!ParseFromByteBuffer(Buffer, Proto)) return false;\n"
+                "  Out = $cn$::Convert(Proto);\n"
+                "  return true;\n"
+                "}\n\n");
+        }
+        if (!codecs.empty()) {
+            //every generated serialization header needs it, so guard against several landing in one translation unit
+            h_p.Print("\n"
+                "#ifndef UNREALGRPC_READWIRESTRING_DEFINED\n"
+                "#define UNREALGRPC_READWIRESTRING_DEFINED\n"
+                "inline bool ReadWireString(FWireReader& Reader, uint32 WireType, FString& Out) {\n"
+                "  const uint8* Data;\n"
+                "  size_t Size;\n"
+                "  if (!Reader.ReadBytes(WireType, Data, Size)) return false;\n"
+                "  FUTF8ToTCHAR Converted(reinterpret_cast<const ANSICHAR*>(Data), static_cast<int32>(Size));\n"
+                "  Out = FString(Converted.Length(), Converted.Get());\n"
+                "  return true;\n"
+                "}\n"
+                "#endif\n\n"
+                "//wire codecs for the messages whose USTRUCT holds every field exactly\n");
+        }
+        for (const Descriptor* msg : codecs) GenerateWireCodec(msg, h_p, cpp_p);
+        h_p.Print("\n}\n");
+        cpp_p.Print("}\n");
+        if (codecs.empty()) return;
+        //calls typed on these USTRUCTs go through their codecs, with no protobuf message in between
+        h_p.Print("\nnamespace grpc {\n\n");
+        for (const Descriptor* msg : codecs) {
+            h_p.Print({{"n", std::string(msg->name())}},
+                "template <>\n"
+                "class SerializationTraits<F$n$> : public UnrealGrpc::TWireSerializationTraits<F$n$> {};\n\n");
+        }
+        h_p.Print("}\n");
+    }
+
+    //statement that writes or reads one value of a field's base UE type
+    static std::string GetNetValueStatement(const FieldDescriptor* field, const std::string& value) {
+        if (field->type() == FieldDescriptor::TYPE_MESSAGE) return value + ".NetSerialize(Ar, Map, bOutSuccess);";
+        if (IsQuantized(field)) return "UnrealGrpc::NetSerializeQuantized(Ar, " + value + ", " + GetQuantization(field) + ");";
+        const std::string base = GetBaseUEType(field);
+        if (base == "FString") return "NetSerializeString(Ar, " + value + ");";
+        if (base == "float" || base == "double") return "Ar << " + value + ";";
+        if (base == "bool") return "UnrealGrpc::NetSerializeBool(Ar, " + value + ");";
+        return "UnrealGrpc::NetSerializeInteger(Ar, " + value + ");";
+    }
+
+    //whether a field differs from its default and has to be sent
+    static std::string GetNetPresence(const FieldDescriptor* field, const std::string& value) {
+        if (field->is_repeated()) return value + ".Num() > 0";
+        if (field->has_presence()) return value + ".IsSet()";
+        const std::string base = GetBaseUEType(field);
+        if (base == "FString") return "!" + value + ".IsEmpty()";
+        if (base == "bool") return value;
+        if (field->type() == FieldDescriptor::TYPE_ENUM) return value + " != static_cast<" + base + ">(0)";
+        //a quantized -0.0 is sent as step zero anyway, but a raw one would be lost to != 0
+        if ((base == "float" || base == "double") && !IsQuantized(field)) return "UnrealGrpc::IsNetPresent(" + value + ")";
+        return value + " != 0";
+    }
+
+    static std::string GetNetFieldStatement(const FieldDescriptor* field, const std::string& value) {
+        const std::string base = GetBaseUEType(field);
+        if (field->is_map()) {
+            const FieldDescriptor* key = field->message_type()->FindFieldByName("key");
+            const FieldDescriptor* val = field->message_type()->FindFieldByName("value");
+            const std::string k = GetBaseUEType(key);
+            const std::string v = GetBaseUEType(val);
+            return "UnrealGrpc::NetSerializeMap<" + k + ", " + v + ">(Ar, " + value + ", [&](" + k + "& Key) { " + GetNetValueStatement(key, "Key") +
+                " }, [&](" + v + "& Value) { " + GetNetValueStatement(val, "Value") + " });";
+        }
+        if (field->is_repeated()) {
+            return "UnrealGrpc::NetSerializeArray(Ar, " + value + ", [&](" + base + "& Value) { " + GetNetValueStatement(field, "Value") + " });";
+        }
+        if (field->has_presence()) {
+            return "{\n  if (Ar.IsLoading()) " + value + ".Emplace();\n  " + GetNetValueStatement(field, value + ".GetValue()") + "\n}";
+        }
+        return GetNetValueStatement(field, value);
+    }
+
+    static void PrintNetSerialize(const Descriptor* msg, io::Printer& printer) {
+        const std::string msg_name = std::string(msg->name());
+        //the oneof cases and then the fields, in the order the struct declares them
+        std::vector<std::pair<std::string, const FieldDescriptor*>> fields;
+        for (int i = 0; i < msg->oneof_decl_count(); i++) {
+            const OneofDescriptor* oneof = msg->oneof_decl(i);
+            if (oneof->field(0)->real_containing_oneof() == nullptr) continue;
+            fields.emplace_back(ToPascalCase(oneof->name()) + "Type", nullptr);
+        }
+        for (int j = 0; j < msg->field_count(); j++) {
+            const FieldDescriptor* f = msg->field(j);
+            if (f->real_containing_oneof() == nullptr && f->containing_oneof() != nullptr) continue;
+            fields.emplace_back(ToPascalCase(f->name()), f);
+        }
+        //members go through this-> so a field named like a parameter (map, ar) isn't shadowed. the presence
+        //bits get an underscore, which PascalCase member names never have
+        for (auto& [name, field] : fields) name = "this->" + name;
+        printer.Print({{"n", msg_name}},
+            "bool F$n$::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess) {\n");
+        printer.Indent();
+        if (fields.empty()) {
+            printer.Print(
+                "bOutSuccess = true;\n"
+                "return true;\n");
+            printer.Outdent();
+            printer.Print("}\n\n");
+            return;
+        }
+        printer.Print({{"n", msg_name}, {"bytes", std::to_string((fields.size() + 7) / 8)}, {"bits", std::to_string(fields.size())}},
+            "uint8 Present_Bits[$bytes$] = {};\n"
+            "if (Ar.IsLoading()) {\n"
+            "  *this = F$n$();\n"
+            "} else {\n");
+        for (size_t i = 0; i < fields.size(); i++) {
+            const auto& [name, field] = fields[i];
+            const std::string presence = field ? GetNetPresence(field, name) : name + " != static_cast<decltype(" + name + ")>(0)";
+            printer.Print({{"p", presence}, {"byte", std::to_string(i / 8)}, {"bit", std::to_string(1u << (i % 8))}},
+                "  if ($p$) Present_Bits[$byte$] |= $bit$;\n");
+        }
+        printer.Print({{"bits", std::to_string(fields.size())}},
+            "}\n"
+            "Ar.SerializeBits(Present_Bits, $bits$);\n");
+        for (size_t i = 0; i < fields.size(); i++) {
+            const auto& [name, field] = fields[i];
+            std::map<std::string, std::string> vars = {{"f", name}, {"byte", std::to_string(i / 8)}, {"bit", std::to_string(1u << (i % 8))}};
+            //a singular bool is true exactly when its bit is set, so it sends nothing else
+            if (field && !field->is_repeated() && !field->has_presence() && GetBaseUEType(field) == "bool") {
+                printer.Print(vars, "$f$ = (Present_Bits[$byte$] & $bit$) != 0;\n");
+                continue;
+            }
+            vars["s"] = field ? GetNetFieldStatement(field, name) : "UnrealGrpc::NetSerializeInteger(Ar, " + name + ");";
+            printer.Print(vars, "if (Present_Bits[$byte$] & $bit$) $s$\n");
+        }
+        printer.Print(
+            "bOutSuccess = !Ar.IsError();\n"
+            "return true;\n");
+        printer.Outdent();
+        printer.Print("}\n\n");
+    }
+
+    static void GenerateNetSerialize(const FileDescriptor* file, const std::string& base_filename, GeneratorContext* context) {
+        const std::unique_ptr<io::ZeroCopyOutputStream> cpp_out(context->Open(base_filename + "NetSerialize.cpp"));
+        io::Printer cpp_p(cpp_out.get(), '$');
+        cpp_p.Print({{"b", base_filename}, {"nh", kNetSerializeHeader}}, "#include \"$b$Converter.h\"\n#include \"$nh$\"\n\n");
+        //strings go as a varint size and UTF-8, instead of FString's 4-byte length and TCHARs. guarded for unity builds
+        cpp_p.Print(
+            "#ifndef UNREALGRPC_NETSERIALIZESTRING_DEFINED\n"
+            "#define UNREALGRPC_NETSERIALIZESTRING_DEFINED\n"
+            "static void NetSerializeString(FArchive& Ar, FString& Value) {\n"
+            "  if (Ar.IsLoading()) {\n"
+            "    uint64 Size = 0;\n"
+            "    UnrealGrpc::NetSerializeVarint(Ar, Size);\n"
+            "    if (Ar.IsError() || Size > static_cast<uint64>(UnrealGrpc::MaxNetStringBytes)) {\n"
+            "      Ar.SetError();\n"
+            "      return;\n"
+            "    }\n"
+            "    TArray<ANSICHAR> Utf8;\n"
+            "    Utf8.SetNumUninitialized(static_cast<int32>(Size));\n"
+            "    Ar.Serialize(Utf8.GetData(), static_cast<int64>(Size));\n"
+            "    FUTF8ToTCHAR Converted(Utf8.GetData(), static_cast<int32>(Size));\n"
+            "    Value = FString(Converted.Length(), Converted.Get());\n"
+            "    return;\n"
+            "  }\n"
+            "  FTCHARToUTF8 Utf8(*Value);\n"
+            "  uint64 Size = static_cast<uint64>(Utf8.Length());\n"
+            "  UnrealGrpc::NetSerializeVarint(Ar, Size);\n"
+            "  Ar.Serialize(const_cast<ANSICHAR*>(Utf8.Get()), static_cast<int64>(Size));\n"
+            "}\n"
+            "#endif\n\n");
+        for (int i = 0; i < file->message_type_count(); i++) {
+            const Descriptor* msg = file->message_type(i);
+            if (msg->options().map_entry() || IsPlainStruct(msg)) continue;
+            PrintNetSerialize(msg, cpp_p);
+        }
+    }
+
     bool Generate(const FileDescriptor* file, const std::string& parameter, GeneratorContext* context, std::string* error) const override {
-        auto base_filename = ToPascalCase(std::string(file->name()));
-        if (base_filename.find_last_of('.') != std::string::npos) base_filename = base_filename.substr(0, base_filename.find_last_of('.'));
+        GeneratorOptions options;
+        if (!ParseOptions(parameter, options, error)) return false;
+        if (!ValidateStreamOptions(file, error)) return false;
+        if (!ValidateSpoolOptions(file, error)) return false;
+        if (!ValidatePlainStructs(file, error)) return false;
+        if (!ValidateQuantizeOptions(file, error)) return false;
+        const std::string base_filename = GetBaseFilename(file);
         std::string proto_ns = file->package().empty() ? "::" : "::" + std::string(file->package()) + "::";
 
         std::string enum_h = base_filename + "Enums.h";
@@ -236,8 +2465,8 @@ public:
             if (msg->options().map_entry()) continue;
             const std::unique_ptr<io::ZeroCopyOutputStream> m_out(context->Open("F" + std::string(msg->name()) + ".h"));
             io::Printer m_p(m_out.get(), '$');
-            m_p.Print({{"eh", enum_h}},
-                "#pragma once\n#include \"CoreMinimal.h\"\n#include \"$eh$\"\n");
+            m_p.Print({{"eh", enum_h}, {"hh", kStructHashHeader}},
+                "#pragma once\n#include \"CoreMinimal.h\"\n#include \"$hh$\"\n#include \"$eh$\"\n");
             std::set<std::string> deps;
             for (int j = 0; j < msg->field_count(); j++) {
                 const FieldDescriptor* f = msg->field(j);
@@ -245,24 +2474,35 @@ public:
                 if (target && target->name() != msg->name() && deps.insert(std::string(target->name())).second) m_p.Print("#include \"F$d$.h\"\n", "d",
                     std::string(target->name()));
             }
-            m_p.Print({{"n", std::string(msg->name())}},
+            if (IsPlainStruct(msg)) m_p.Print("\n");
+            else m_p.Print({{"n", std::string(msg->name())}},
                 "#include \"F$n$.generated.h\"\n\n");
-            GenerateStruct(msg, m_p);
+            GenerateStruct(msg, options.bGenerateNetSerialize, m_p);
         }
 
         const std::unique_ptr<io::ZeroCopyOutputStream> ch_out(context->Open(base_filename + "Converter.h"));
         io::Printer converter_h_printer(ch_out.get(), '$');
         converter_h_printer.Print({{"b", base_filename}}, "#pragma once\n#include \"CoreMinimal.h\"\n#include \"$b$.pb.h\"\n");
         for (int i = 0; i < file->message_type_count(); i++) if (!file->message_type(i)->options().map_entry()) converter_h_printer.Print("#include \"F$n$.h\"\n", "n", std::string(file->message_type(i)->name()));
-        converter_h_printer.Print({{"cn", kConverterClassName}}, "\nclass $cn$ {\n");
+        converter_h_printer.Print({{"cn", kConverterClassName}}, "\nclass $cn$ {\npublic:\n");
         converter_h_printer.Indent();
-        for (int i = 0; i < file->message_type_count(); i++) if (!file->message_type(i)->options().map_entry()) converter_h_printer.Print({{"n", std::string(file->message_type(i)->name())}, {"ns", proto_ns}}, "static F$n$ Convert(const $ns$$n$& In);\n");
+        for (int i = 0; i < file->message_type_count(); i++) if (!file->message_type(i)->options().map_entry()) converter_h_printer.Print({{"n", std::string(file->message_type(i)->name())}, {"ns", proto_ns}}, "static F$n$ Convert(const $ns$$n$& In);\nstatic void ToProto(const F$n$& In, $ns$$n$& Out);\n");
         converter_h_printer.Outdent(); converter_h_printer.Print("};\n");
 
         const std::unique_ptr<io::ZeroCopyOutputStream> cpp_out(context->Open(base_filename + "Converter.cpp"));
         io::Printer converter_cpp_printer(cpp_out.get(), '$');
         converter_cpp_printer.Print({{"b", base_filename}}, "#include \"$b$Converter.h\"\n#include \"$b$.pb.h\"\n");
-        for (int i = 0; i < file->message_type_count(); i++) if (!file->message_type(i)->options().map_entry()) GenerateStaticConversionFunction(file->message_type(i), converter_cpp_printer, proto_ns);
+        if (HasQuantizedFields(file)) converter_cpp_printer.Print({{"qh", kQuantizeHeader}}, "#include \"$qh$\"\n");
+        for (int i = 0; i < file->message_type_count(); i++) if (!file->message_type(i)->options().map_entry()) {
+            GenerateStaticConversionFunction(file->message_type(i), converter_cpp_printer, proto_ns);
+            GenerateToProtoFunction(file->message_type(i), converter_cpp_printer, proto_ns);
+        }
+
+        if (options.bGenerateClients && file->service_count() > 0) GenerateServiceClients(file, base_filename, options, context);
+        if (options.bGenerateLoopback && file->service_count() > 0) GenerateLoopback(file, base_filename, options, context);
+        if (options.bGenerateServers && file->service_count() > 0) GenerateServers(file, base_filename, context);
+        if (options.bGenerateSerialization) GenerateSerialization(file, base_filename, proto_ns, context);
+        if (options.bGenerateNetSerialize) GenerateNetSerialize(file, base_filename, context);
         return true;
     }
 };
@@ -0,0 +1,45 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <grpcpp/grpcpp.h>
+#include "UnrealGrpc/GrpcCancellation.h"
+#include "UnrealGrpc/GrpcChannelPool.h"
+
+namespace UnrealGrpc {
+
+/**
+ * A single unary call on gRPC's callback API, the alternative to TAsyncUnaryCall for clients
+ * generated with client_api=callback. gRPC runs OnDone on its own callback threads, so no
+ * polling thread is needed and a completion costs one thread hop fewer. Owns the request and
+ * response for the lifetime of the call and deletes itself after handing the result to OnDone.
+ */
+template <typename TRequest, typename TResponse>
+class TCallbackUnaryCall final : public grpc::ClientUnaryReactor {
+public:
+    using FOnDone = std::function<void(const grpc::Status&, const TResponse&)>;
+
+    TCallbackUnaryCall(FChannelPool::FLease&& InLease, TRequest&& InRequest, FOnDone&& InOnDone)
+        : Request(std::move(InRequest)), Lease(std::move(InLease)), OnDoneFunc(std::move(InOnDone)) {}
+
+    [[nodiscard]] int32_t GetChannelIndex() const { return Lease.GetIndex(); }
+
+    void OnDone(const grpc::Status& Status) override {
+        Lease.Release();
+        Cancellation.Reset();
+        if (OnDoneFunc) OnDoneFunc(Status, Response);
+        delete this;
+    }
+
+    grpc::ClientContext Context;
+    /** Declared after Context so it unregisters before the context goes away. */
+    FCancellationToken::FRegistration Cancellation;
+    const TRequest Request;
+    TResponse Response;
+
+private:
+    FChannelPool::FLease Lease;
+    FOnDone OnDoneFunc;
+};
+
+}
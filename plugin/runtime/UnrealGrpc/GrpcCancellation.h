@@ -0,0 +1,117 @@
+#pragma once
+#include <memory>
+#include <mutex>
+#include <unordered_set>
+#include <utility>
+#include <grpcpp/grpcpp.h>
+
+namespace UnrealGrpc {
+
+/**
+ * Handle passed to calls that should stop when their owner goes away. Cancelling reaches every call
+ * registered with the token, and calls registered after that are cancelled as they start.
+ * Default-constructed tokens are never cancelled and cost nothing. Get one from FCancellationSource.
+ */
+class FCancellationToken {
+    struct FState {
+        std::mutex Mutex;
+        std::unordered_set<grpc::ClientContext*> Contexts;
+        bool bCancelled = false;
+    };
+
+public:
+    /**
+     * Keeps a call's context registered for as long as it is alive. Destroy it before the context.
+     */
+    class FRegistration {
+    public:
+        FRegistration() = default;
+        FRegistration(FRegistration&& Other) noexcept : State(std::move(Other.State)), Context(Other.Context) { Other.Context = nullptr; }
+        FRegistration& operator=(FRegistration&& Other) noexcept {
+            if (this != &Other) {
+                Reset();
+                State = std::move(Other.State);
+                Context = Other.Context;
+                Other.Context = nullptr;
+            }
+            return *this;
+        }
+        FRegistration(const FRegistration&) = delete;
+        FRegistration& operator=(const FRegistration&) = delete;
+        ~FRegistration() { Reset(); }
+
+        void Reset() {
+            if (State && Context) {
+                std::lock_guard Lock(State->Mutex);
+                State->Contexts.erase(Context);
+            }
+            State.reset();
+            Context = nullptr;
+        }
+
+    private:
+        friend class FCancellationToken;
+        FRegistration(std::shared_ptr<FState> InState, grpc::ClientContext* InContext) : State(std::move(InState)), Context(InContext) {}
+        std::shared_ptr<FState> State;
+        grpc::ClientContext* Context = nullptr;
+    };
+
+    FCancellationToken() = default;
+
+    [[nodiscard]] bool IsCancelled() const {
+        if (!State) return false;
+        std::lock_guard Lock(State->Mutex);
+        return State->bCancelled;
+    }
+
+    /** Cancels the call on Context when the token is cancelled. Safe to call before the call starts. */
+    [[nodiscard]] FRegistration Register(grpc::ClientContext& Context) const {
+        if (!State) return {};
+        std::lock_guard Lock(State->Mutex);
+        if (State->bCancelled) {
+            Context.TryCancel();
+            return {};
+        }
+        State->Contexts.insert(&Context);
+        return FRegistration(State, &Context);
+    }
+
+private:
+    friend class FCancellationSource;
+    explicit FCancellationToken(std::shared_ptr<FState> InState) : State(std::move(InState)) {}
+    std::shared_ptr<FState> State;
+};
+
+/**
+ * Owns the cancellation for a scope such as a level or a frame, and cancels it when destroyed.
+ * Cancelled calls complete with CANCELLED straight away, releasing their completion-queue slot
+ * and buffers instead of holding them until the server answers.
+ */
+class FCancellationSource {
+public:
+    FCancellationSource() : Token(std::make_shared<FCancellationToken::FState>()) {}
+    ~FCancellationSource() { Cancel(); }
+    FCancellationSource(const FCancellationSource&) = delete;
+    FCancellationSource& operator=(const FCancellationSource&) = delete;
+
+    [[nodiscard]] const FCancellationToken& GetToken() const { return Token; }
+
+    void Cancel() {
+        std::lock_guard Lock(Token.State->Mutex);
+        Token.State->bCancelled = true;
+        //the registration lock is held, so no context can be destroyed while it is being cancelled
+        for (grpc::ClientContext* Context : Token.State->Contexts) Context->TryCancel();
+        Token.State->Contexts.clear();
+    }
+
+    /** Cancels the calls made so far and hands out a fresh token, e.g. at the end of each frame. */
+    void Reset() {
+        Cancel();
+        Token.State = std::make_shared<FCancellationToken::FState>();
+    }
+
+private:
+    FCancellationToken Token;
+};
+
+}
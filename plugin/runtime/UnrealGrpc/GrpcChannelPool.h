@@ -0,0 +1,244 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <grpcpp/grpcpp.h>
+#include <grpcpp/support/client_interceptor.h>
+#include "UnrealGrpc/GrpcCancellation.h"
+
+namespace UnrealGrpc {
+
+/**
+ * Settings for an FChannelPool.
+ */
+struct FChannelPoolConfig {
+    /** Number of channels to spread calls across. Each channel owns its own HTTP/2 connection. */
+    int32_t NumChannels = 4;
+    std::shared_ptr<grpc::ChannelCredentials> Credentials = grpc::InsecureChannelCredentials();
+    /** Base arguments applied to every channel before the per-channel sharding arguments. */
+    grpc::ChannelArguments Arguments;
+    /** Each channel owns its interceptor factories, so these are called once per channel. */
+    std::vector<std::function<std::unique_ptr<grpc::experimental::ClientInterceptorFactoryInterface>()>> InterceptorFactories;
+};
+
+/**
+ * Anything handed to the pool's completion queue as a tag. OnComplete runs on the polling thread.
+ */
+class FCompletionTag {
+public:
+    virtual ~FCompletionTag() = default;
+    virtual void OnComplete(bool bOk) = 0;
+};
+
+/**
+ * A fixed set of channels to the same target, each forced onto its own connection.
+ * Calls pick the channel with the fewest outstanding RPCs so a single connection's
+ * max-concurrent-streams limit no longer caps throughput.
+ */
+class FChannelPool {
+public:
+    /**
+     * Marks one outstanding RPC on a channel for as long as it is alive.
+     */
+    class FLease {
+    public:
+        FLease() = default;
+        FLease(FLease&& Other) noexcept : Pool(Other.Pool), Index(Other.Index) { Other.Pool = nullptr; }
+        FLease& operator=(FLease&& Other) noexcept {
+            if (this != &Other) {
+                Release();
+                Pool = Other.Pool;
+                Index = Other.Index;
+                Other.Pool = nullptr;
+            }
+            return *this;
+        }
+        FLease(const FLease&) = delete;
+        FLease& operator=(const FLease&) = delete;
+        ~FLease() { Release(); }
+
+        [[nodiscard]] int32_t GetIndex() const { return Index; }
+        [[nodiscard]] bool IsValid() const { return Pool != nullptr; }
+
+        void Release() {
+            if (Pool) Pool->Slots[Index].Outstanding.fetch_sub(1, std::memory_order_relaxed);
+            Pool = nullptr;
+        }
+
+    private:
+        friend class FChannelPool;
+        FLease(FChannelPool* InPool, int32_t InIndex) : Pool(InPool), Index(InIndex) {}
+        FChannelPool* Pool = nullptr;
+        int32_t Index = 0;
+    };
+
+    explicit FChannelPool(const std::string& Target, const FChannelPoolConfig& Config = {})
+        : NumSlots(Config.NumChannels > 0 ? Config.NumChannels : 1), Slots(new FSlot[NumSlots]), bOwnsConnections(true) {
+        for (int32_t i = 0; i < NumSlots; i++) {
+            grpc::ChannelArguments Args = Config.Arguments;
+            //channels with identical arguments share subchannels, so give each its own pool and a unique arg
+            Args.SetInt(GRPC_ARG_USE_LOCAL_SUBCHANNEL_POOL, 1);
+            Args.SetInt("unreal_grpc.channel_index", i);
+            std::vector<std::unique_ptr<grpc::experimental::ClientInterceptorFactoryInterface>> Interceptors;
+            for (const auto& MakeFactory : Config.InterceptorFactories) Interceptors.push_back(MakeFactory());
+            Slots[i].Channel = Interceptors.empty()
+                ? grpc::CreateCustomChannel(Target, Config.Credentials, Args)
+                : grpc::experimental::CreateCustomChannelWithInterceptors(Target, Config.Credentials, Args, std::move(Interceptors));
+        }
+    }
+
+    /**
+     * Wraps channels created elsewhere, such as in-process channels to a local grpc::Server. Needs at
+     * least one; an empty list is logged and gets a single channel whose calls all fail.
+     */
+    explicit FChannelPool(std::vector<std::shared_ptr<grpc::Channel>> Channels)
+        : NumSlots(std::max(static_cast<int32_t>(Channels.size()), 1)), Slots(new FSlot[NumSlots]) {
+        for (int32_t i = 0; i < static_cast<int32_t>(Channels.size()); i++) Slots[i].Channel = std::move(Channels[i]);
+        if (Channels.empty()) {
+            //checked in every build type, since exceptions are off in UE. gRPC makes an empty target a lame
+            //channel, so calls fail straight away instead of crashing on a null channel
+            std::fprintf(stderr, "UnrealGrpc: FChannelPool was given no channels; every call on it will fail\n");
+            Slots[0].Channel = grpc::CreateChannel("", grpc::InsecureChannelCredentials());
+        }
+    }
+
+    ~FChannelPool() {
+        {
+            std::unique_lock Lock(ShutdownMutex);
+            bShutdown = true;
+        }
+        if (PollingThread.joinable()) {
+            Queue.Shutdown();
+            PollingThread.join();
+        }
+    }
+
+    FChannelPool(const FChannelPool&) = delete;
+    FChannelPool& operator=(const FChannelPool&) = delete;
+
+    /** Picks the channel with the fewest outstanding RPCs. Ties rotate so idle pools still spread load. */
+    [[nodiscard]] FLease Acquire() {
+        const int32_t Start = static_cast<int32_t>(NextStart.fetch_add(1, std::memory_order_relaxed) % static_cast<uint32_t>(NumSlots));
+        int32_t Best = Start;
+        int32_t BestLoad = Slots[Start].Outstanding.load(std::memory_order_relaxed);
+        for (int32_t i = 1; i < NumSlots && BestLoad > 0; i++) {
+            const int32_t Index = (Start + i) % NumSlots;
+            const int32_t Load = Slots[Index].Outstanding.load(std::memory_order_relaxed);
+            if (Load < BestLoad) {
+                Best = Index;
+                BestLoad = Load;
+            }
+        }
+        Slots[Best].Outstanding.fetch_add(1, std::memory_order_relaxed);
+        return FLease(this, Best);
+    }
+
+    [[nodiscard]] int32_t Num() const { return NumSlots; }
+    /** False for wrapped channels, which may be in-process and have no connectivity state to wait on. */
+    [[nodiscard]] bool OwnsConnections() const { return bOwnsConnections; }
+    [[nodiscard]] const std::shared_ptr<grpc::Channel>& GetChannel(int32_t Index) const { return Slots[Index].Channel; }
+    [[nodiscard]] int32_t GetOutstanding(int32_t Index) const { return Slots[Index].Outstanding.load(std::memory_order_relaxed); }
+
+    /** Completion queue shared by every async call on this pool. The polling thread starts on first use. */
+    grpc::CompletionQueue* GetCompletionQueue() {
+        std::call_once(PollingThreadStarted, [this] {
+            PollingThread = std::thread([this] {
+                PollingThreadId.store(std::this_thread::get_id(), std::memory_order_relaxed);
+                void* Tag = nullptr;
+                bool bOk = false;
+                while (Queue.Next(&Tag, &bOk)) static_cast<FCompletionTag*>(Tag)->OnComplete(bOk);
+            });
+        });
+        return &Queue;
+    }
+
+    /**
+     * True on the thread that polls the completion queue. Anything that blocks on a completion from this
+     * queue would deadlock there, since the thread that has to deliver it is the one waiting.
+     */
+    [[nodiscard]] bool IsPollingThread() const {
+        return PollingThreadId.load(std::memory_order_relaxed) == std::this_thread::get_id();
+    }
+
+    /**
+     * Runs Start, which puts work on the completion queue, unless the pool is being destroyed. For
+     * work queued from a completion, such as a retry, which may run while the queue drains. Returns
+     * whether Start ran.
+     */
+    template <typename FStart>
+    bool RunIfOpen(FStart&& Start) {
+        std::shared_lock Lock(ShutdownMutex);
+        if (bShutdown) return false;
+        Start();
+        return true;
+    }
+
+private:
+    //padded so the outstanding counters of neighbouring channels don't share a cache line
+    struct alignas(64) FSlot {
+        std::shared_ptr<grpc::Channel> Channel;
+        std::atomic<int32_t> Outstanding{0};
+    };
+
+    const int32_t NumSlots;
+    std::unique_ptr<FSlot[]> Slots;
+    const bool bOwnsConnections = false;
+    std::atomic<uint32_t> NextStart{0};
+    grpc::CompletionQueue Queue;
+    std::once_flag PollingThreadStarted;
+    std::thread PollingThread;
+    //set by the polling thread itself, so IsPollingThread never reads the std::thread while call_once assigns it
+    std::atomic<std::thread::id> PollingThreadId;
+    //held shared while queueing work, so nothing is queued once the destructor has shut the queue down
+    std::shared_mutex ShutdownMutex;
+    bool bShutdown = false;
+};
+
+/**
+ * A single in-flight unary call on the pool's completion queue. Owns everything the call
+ * needs and deletes itself once the response (or error) has been handed to OnDone.
+ */
+template <typename TResponse>
+class TAsyncUnaryCall final : public FCompletionTag {
+public:
+    using FOnDone = std::function<void(const grpc::Status&, const TResponse&)>;
+
+    TAsyncUnaryCall(FChannelPool::FLease&& InLease, FOnDone&& InOnDone)
+        : Lease(std::move(InLease)), OnDone(std::move(InOnDone)) {}
+
+    [[nodiscard]] int32_t GetChannelIndex() const { return Lease.GetIndex(); }
+
+    void Start(std::unique_ptr<grpc::ClientAsyncResponseReader<TResponse>> InReader) {
+        Reader = std::move(InReader);
+        Reader->StartCall();
+        Reader->Finish(&Response, &Status, this);
+    }
+
+    void OnComplete(bool) override {
+        Lease.Release();
+        Cancellation.Reset();
+        if (OnDone) OnDone(Status, Response);
+        delete this;
+    }
+
+    grpc::ClientContext Context;
+    /** Declared after Context so it unregisters before the context goes away. */
+    FCancellationToken::FRegistration Cancellation;
+
+private:
+    FChannelPool::FLease Lease;
+    FOnDone OnDone;
+    std::unique_ptr<grpc::ClientAsyncResponseReader<TResponse>> Reader;
+    TResponse Response;
+    grpc::Status Status;
+};
+
+}
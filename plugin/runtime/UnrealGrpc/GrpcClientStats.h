@@ -0,0 +1,236 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <map>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <google/protobuf/message_lite.h>
+#include <grpcpp/grpcpp.h>
+#include <grpcpp/support/client_interceptor.h>
+#include "UnrealGrpc/GrpcLatencyHistogram.h"
+#include "UnrealGrpc/GrpcSerialization.h"
+
+namespace UnrealGrpc {
+
+/** Merged view of one method's stats at the time of the read. */
+struct FMethodStatsSnapshot {
+    std::string Method;
+    uint64_t Calls = 0;
+    uint64_t FailedCalls = 0;
+    uint64_t BytesSent = 0;
+    uint64_t BytesReceived = 0;
+    /** Time on the wire: from sending initial metadata to receiving the status, excluding USTRUCT conversion. */
+    FLatencyHistogram Wire;
+    /** Time spent in ToProto and Convert for the call, recorded by the generated clients. */
+    FLatencyHistogram Conversion;
+};
+
+/**
+ * Stats for a single RPC method. Writers only touch the shard owned by their thread, using relaxed
+ * atomics, so recording never takes a lock or bounces a cache line between threads. Reads merge
+ * every shard into an FMethodStatsSnapshot.
+ */
+class FMethodStats {
+public:
+    static constexpr int32_t MaxShards = 16;
+
+    explicit FMethodStats(std::string InMethod) : Method(std::move(InMethod)) {}
+
+    ~FMethodStats() {
+        for (auto& Shard : Shards) delete Shard.load(std::memory_order_relaxed);
+    }
+
+    FMethodStats(const FMethodStats&) = delete;
+    FMethodStats& operator=(const FMethodStats&) = delete;
+
+    [[nodiscard]] const std::string& GetMethod() const { return Method; }
+
+    void RecordCall(uint64_t WireNanos, uint64_t BytesSent, uint64_t BytesReceived, bool bOk) {
+        FShard& Shard = GetShard();
+        Shard.Wire[FLatencyHistogram::GetBucketIndex(WireNanos)].fetch_add(1, std::memory_order_relaxed);
+        Shard.BytesSent.fetch_add(BytesSent, std::memory_order_relaxed);
+        Shard.BytesReceived.fetch_add(BytesReceived, std::memory_order_relaxed);
+        if (!bOk) Shard.FailedCalls.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void RecordConversion(uint64_t Nanos) {
+        GetShard().Conversion[FLatencyHistogram::GetBucketIndex(Nanos)].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] FMethodStatsSnapshot Snapshot() const {
+        FMethodStatsSnapshot Out;
+        Out.Method = Method;
+        for (const auto& ShardPtr : Shards) {
+            const FShard* Shard = ShardPtr.load(std::memory_order_acquire);
+            if (!Shard) continue;
+            for (int32_t i = 0; i < FLatencyHistogram::NumBuckets; i++) {
+                Out.Wire.RecordBucket(i, Shard->Wire[i].load(std::memory_order_relaxed));
+                Out.Conversion.RecordBucket(i, Shard->Conversion[i].load(std::memory_order_relaxed));
+            }
+            Out.FailedCalls += Shard->FailedCalls.load(std::memory_order_relaxed);
+            Out.BytesSent += Shard->BytesSent.load(std::memory_order_relaxed);
+            Out.BytesReceived += Shard->BytesReceived.load(std::memory_order_relaxed);
+        }
+        Out.Calls = Out.Wire.GetCount();
+        return Out;
+    }
+
+private:
+    struct FShard {
+        std::array<std::atomic<uint64_t>, FLatencyHistogram::NumBuckets> Wire{};
+        std::array<std::atomic<uint64_t>, FLatencyHistogram::NumBuckets> Conversion{};
+        std::atomic<uint64_t> FailedCalls{0};
+        std::atomic<uint64_t> BytesSent{0};
+        std::atomic<uint64_t> BytesReceived{0};
+    };
+
+    //threads are numbered once and share a shard only when there are more than MaxShards of them
+    static int32_t GetThreadShardIndex() {
+        static std::atomic<int32_t> NextThread{0};
+        thread_local const int32_t Index = NextThread.fetch_add(1, std::memory_order_relaxed) % MaxShards;
+        return Index;
+    }
+
+    //shards are allocated on first use, so a method only pays for the threads that call it
+    FShard& GetShard() {
+        std::atomic<FShard*>& Slot = Shards[GetThreadShardIndex()];
+        FShard* Shard = Slot.load(std::memory_order_acquire);
+        if (Shard) return *Shard;
+        auto* NewShard = new FShard();
+        if (Slot.compare_exchange_strong(Shard, NewShard, std::memory_order_acq_rel)) return *NewShard;
+        delete NewShard;
+        return *Shard;
+    }
+
+    const std::string Method;
+    std::array<std::atomic<FShard*>, MaxShards> Shards{};
+};
+
+/**
+ * Process-wide registry of FMethodStats, keyed by the full method path ("/package.Service/Method").
+ * Entries are never removed, so references returned by FindOrAdd stay valid for the process lifetime.
+ */
+class FClientStats {
+public:
+    static FClientStats& Get() {
+        static FClientStats Instance;
+        return Instance;
+    }
+
+    FMethodStats& FindOrAdd(std::string_view Method) {
+        {
+            std::shared_lock Lock(Mutex);
+            if (const auto It = Methods.find(Method); It != Methods.end()) return *It->second;
+        }
+        std::unique_lock Lock(Mutex);
+        auto& Entry = Methods[std::string(Method)];
+        if (!Entry) Entry = std::make_unique<FMethodStats>(std::string(Method));
+        return *Entry;
+    }
+
+    [[nodiscard]] std::vector<FMethodStatsSnapshot> Snapshot() const {
+        std::shared_lock Lock(Mutex);
+        std::vector<FMethodStatsSnapshot> Out;
+        Out.reserve(Methods.size());
+        for (const auto& [Name, Stats] : Methods) Out.push_back(Stats->Snapshot());
+        return Out;
+    }
+
+    /** Writes one CSV row per method with latencies in microseconds. Returns false if the file can't be written. */
+    bool DumpToFile(const std::string& Path) const {
+        FILE* File = std::fopen(Path.c_str(), "w");
+        if (!File) return false;
+        std::fprintf(File, "method,calls,failed,bytes_sent,bytes_received,"
+            "wire_p50_us,wire_p99_us,wire_p999_us,wire_max_us,conversion_p50_us,conversion_p99_us,conversion_max_us\n");
+        const auto Us = [](uint64_t Nanos) { return static_cast<double>(Nanos) / 1000.0; };
+        for (const FMethodStatsSnapshot& Stats : Snapshot()) {
+            std::fprintf(File, "%s,%llu,%llu,%llu,%llu,%.1f,%.1f,%.1f,%.1f,%.1f,%.1f,%.1f\n", Stats.Method.c_str(),
+                static_cast<unsigned long long>(Stats.Calls), static_cast<unsigned long long>(Stats.FailedCalls),
+                static_cast<unsigned long long>(Stats.BytesSent), static_cast<unsigned long long>(Stats.BytesReceived),
+                Us(Stats.Wire.GetPercentile(50)), Us(Stats.Wire.GetPercentile(99)), Us(Stats.Wire.GetPercentile(99.9)), Us(Stats.Wire.GetMax()),
+                Us(Stats.Conversion.GetPercentile(50)), Us(Stats.Conversion.GetPercentile(99)), Us(Stats.Conversion.GetMax()));
+        }
+        return std::fclose(File) == 0;
+    }
+
+private:
+    FClientStats() = default;
+
+    mutable std::shared_mutex Mutex;
+    std::map<std::string, std::unique_ptr<FMethodStats>, std::less<>> Methods;
+};
+
+/**
+ * Accumulates the conversion work of one call, which is split around the RPC, and records it once.
+ * Copyable so async calls can carry it into their completion callback.
+ */
+class FConversionTimer {
+public:
+    explicit FConversionTimer(FMethodStats& InStats) : Stats(&InStats) {}
+
+    template <typename TFunc>
+    void Time(TFunc&& Func) {
+        const auto Start = std::chrono::steady_clock::now();
+        Func();
+        Nanos += static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - Start).count());
+    }
+
+    void Commit() const { Stats->RecordConversion(Nanos); }
+
+private:
+    FMethodStats* Stats;
+    uint64_t Nanos = 0;
+};
+
+/**
+ * Records wire latency, payload sizes and status for every call on the channel into FClientStats.
+ * Received sizes come from the deserialized message, which is protobuf unless the call was
+ * created inside an FScopedRecvCodec.
+ */
+class FStatsInterceptor final : public grpc::experimental::Interceptor {
+public:
+    FStatsInterceptor(FMethodStats& InStats, const FRecvCodec* InCodec) : Stats(InStats), Codec(InCodec) {}
+
+    void Intercept(grpc::experimental::InterceptorBatchMethods* Methods) override {
+        using grpc::experimental::InterceptionHookPoints;
+        if (Methods->QueryInterceptionHookPoint(InterceptionHookPoints::PRE_SEND_INITIAL_METADATA)) {
+            Start = std::chrono::steady_clock::now();
+        }
+        //serializing here is free: gRPC sends the buffer we force, rather than serializing again
+        if (Methods->QueryInterceptionHookPoint(InterceptionHookPoints::PRE_SEND_MESSAGE)) {
+            if (const grpc::ByteBuffer* Buffer = Methods->GetSerializedSendMessage()) BytesSent += Buffer->Length();
+        }
+        if (Methods->QueryInterceptionHookPoint(InterceptionHookPoints::POST_RECV_MESSAGE)) {
+            if (const void* Message = Methods->GetRecvMessage()) BytesReceived += GetRecvSize(Codec, Message);
+        }
+        if (Methods->QueryInterceptionHookPoint(InterceptionHookPoints::POST_RECV_STATUS)) {
+            const auto Nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - Start).count();
+            Stats.RecordCall(static_cast<uint64_t>(Nanos), BytesSent, BytesReceived, Methods->GetRecvStatus()->ok());
+        }
+        Methods->Proceed();
+    }
+
+private:
+    FMethodStats& Stats;
+    const FRecvCodec* Codec;
+    std::chrono::steady_clock::time_point Start;
+    uint64_t BytesSent = 0;
+    uint64_t BytesReceived = 0;
+};
+
+class FStatsInterceptorFactory final : public grpc::experimental::ClientInterceptorFactoryInterface {
+public:
+    grpc::experimental::Interceptor* CreateClientInterceptor(grpc::experimental::ClientRpcInfo* Info) override {
+        //interceptors are created with the call, on the thread that starts it
+        return new FStatsInterceptor(FClientStats::Get().FindOrAdd(Info->method()), FScopedRecvCodec::Get());
+    }
+};
+
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <grpcpp/grpcpp.h>
+#include "UnrealGrpc/GrpcRequestKey.h"
+
+namespace UnrealGrpc {
+
+/**
+ * Folds identical in-flight unary calls into one. The first caller for a key starts the RPC;
+ * later callers with the same key just wait, and every waiter receives the same converted
+ * response when it completes. Keys are the serialized requests themselves, so two different
+ * requests can never be merged by a hash collision.
+ */
+template <typename TResponse>
+class TCallCoalescer {
+public:
+    using FOnDone = std::function<void(const grpc::Status&, const TResponse&)>;
+
+    /** Registers OnDone for Key. Returns true if the caller is the first and must start the call. */
+    bool Join(const std::string& Key, FOnDone&& OnDone) {
+        std::lock_guard Lock(Mutex);
+        auto [It, bInserted] = InFlight.try_emplace(Key);
+        It->second.push_back(std::move(OnDone));
+        return bInserted;
+    }
+
+    /** Hands the result to everyone waiting on Key. Calls joining after this start a new RPC. */
+    void Complete(const std::string& Key, const grpc::Status& Status, const TResponse& Response) {
+        std::vector<FOnDone> Waiters;
+        {
+            std::lock_guard Lock(Mutex);
+            const auto It = InFlight.find(Key);
+            if (It == InFlight.end()) return;
+            Waiters = std::move(It->second);
+            InFlight.erase(It);
+        }
+        for (const FOnDone& OnDone : Waiters) {
+            if (OnDone) OnDone(Status, Response);
+        }
+    }
+
+    [[nodiscard]] size_t NumInFlight() const {
+        std::lock_guard Lock(Mutex);
+        return InFlight.size();
+    }
+
+private:
+    mutable std::mutex Mutex;
+    std::unordered_map<std::string, std::vector<FOnDone>> InFlight;
+};
+
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include <cstddef>
+#include <google/protobuf/message_lite.h>
+#include <grpcpp/grpcpp.h>
+
+namespace UnrealGrpc {
+
+/**
+ * Chooses per call whether to compress a message. Small messages are sent as they are, because
+ * compressing them costs more CPU than the bytes it saves and the framing can make them bigger.
+ * The size comes from ByteSizeLong, which walks the message but doesn't serialize it.
+ */
+struct FCompressionPolicy {
+    grpc_compression_algorithm Algorithm = GRPC_COMPRESS_GZIP;
+    /** Messages smaller than this are sent uncompressed. */
+    size_t MinBytes = 1024;
+
+    [[nodiscard]] grpc_compression_algorithm Choose(const google::protobuf::MessageLite& Message) const {
+        return Message.ByteSizeLong() >= MinBytes ? Algorithm : GRPC_COMPRESS_NONE;
+    }
+
+    /** Sets the request compression for a client call. */
+    void Apply(grpc::ClientContext& Context, const google::protobuf::MessageLite& Request) const {
+        Context.set_compression_algorithm(Choose(Request));
+    }
+
+    /**
+     * Sets the response compression from a server handler, sync or callback. The client must accept
+     * the algorithm, which gRPC clients do by default.
+     */
+    void Apply(grpc::ServerContextBase& Context, const google::protobuf::MessageLite& Response) const {
+        Context.set_compression_algorithm(Choose(Response));
+    }
+};
+
+}
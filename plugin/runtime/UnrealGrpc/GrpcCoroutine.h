@@ -0,0 +1,372 @@
+#pragma once
+#include <algorithm>
+#include <condition_variable>
+#include <coroutine>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <grpcpp/grpcpp.h>
+#include "UnrealGrpc/GrpcCancellation.h"
+#include "UnrealGrpc/GrpcChannelPool.h"
+
+namespace UnrealGrpc {
+
+/**
+ * A suspended coroutine waiting to be resumed by an executor. It lives inside the awaiter, which
+ * lives in the coroutine frame, so handing a resumption to an executor never allocates.
+ */
+struct FResumption {
+    std::coroutine_handle<> Handle;
+    FResumption* Next = nullptr;
+};
+
+/**
+ * Decides which thread a coroutine continues on after an RPC completes.
+ */
+class FExecutor {
+public:
+    virtual ~FExecutor() = default;
+    virtual void Post(FResumption& Resumption) = 0;
+};
+
+/** Resumes right away on the thread that completed the RPC, i.e. the pool's polling thread. */
+class FInlineExecutor final : public FExecutor {
+public:
+    static FInlineExecutor& Get() {
+        static FInlineExecutor Executor;
+        return Executor;
+    }
+
+    void Post(FResumption& Resumption) override { Resumption.Handle.resume(); }
+};
+
+/**
+ * Queues resumptions until their owning thread calls RunPending, e.g. once per game-thread tick,
+ * so coroutines continue there and can touch UObjects.
+ */
+class FQueuedExecutor final : public FExecutor {
+public:
+    void Post(FResumption& Resumption) override {
+        std::lock_guard Lock(Mutex);
+        Resumption.Next = nullptr;
+        if (Tail) Tail->Next = &Resumption;
+        else Head = &Resumption;
+        Tail = &Resumption;
+    }
+
+    /** Resumes everything posted so far, in order. Returns how many coroutines ran. */
+    int32_t RunPending() {
+        FResumption* Pending = nullptr;
+        {
+            std::lock_guard Lock(Mutex);
+            Pending = Head;
+            Head = Tail = nullptr;
+        }
+        int32_t Count = 0;
+        while (Pending) {
+            //resuming can finish the coroutine and free the node, so step past it first
+            FResumption* Current = Pending;
+            Pending = Pending->Next;
+            Current->Handle.resume();
+            Count++;
+        }
+        return Count;
+    }
+
+private:
+    std::mutex Mutex;
+    FResumption* Head = nullptr;
+    FResumption* Tail = nullptr;
+};
+
+/**
+ * A fixed set of worker threads that resume coroutines in the order they were posted. Anything
+ * still queued when the pool is destroyed is resumed before the workers exit.
+ */
+class FWorkerPoolExecutor final : public FExecutor {
+public:
+    explicit FWorkerPoolExecutor(int32_t NumThreads = 2) {
+        for (int32_t i = 0; i < std::max(NumThreads, 1); i++) Workers.emplace_back([this] { Work(); });
+    }
+
+    ~FWorkerPoolExecutor() override {
+        {
+            std::lock_guard Lock(Mutex);
+            bStopping = true;
+        }
+        Wake.notify_all();
+        for (std::thread& Worker : Workers) Worker.join();
+    }
+
+    FWorkerPoolExecutor(const FWorkerPoolExecutor&) = delete;
+    FWorkerPoolExecutor& operator=(const FWorkerPoolExecutor&) = delete;
+
+    void Post(FResumption& Resumption) override {
+        {
+            std::lock_guard Lock(Mutex);
+            Resumption.Next = nullptr;
+            if (Tail) Tail->Next = &Resumption;
+            else Head = &Resumption;
+            Tail = &Resumption;
+        }
+        Wake.notify_one();
+    }
+
+private:
+    void Work() {
+        for (;;) {
+            FResumption* Current = nullptr;
+            {
+                std::unique_lock Lock(Mutex);
+                Wake.wait(Lock, [this] { return Head != nullptr || bStopping; });
+                if (!Head) return;
+                Current = Head;
+                Head = Head->Next;
+                if (!Head) Tail = nullptr;
+            }
+            Current->Handle.resume();
+        }
+    }
+
+    std::mutex Mutex;
+    std::condition_variable Wake;
+    FResumption* Head = nullptr;
+    FResumption* Tail = nullptr;
+    bool bStopping = false;
+    std::vector<std::thread> Workers;
+};
+
+/**
+ * Return type for coroutines that nobody awaits, such as a chain of RPCs started from game code.
+ * It starts running immediately and frees its frame when it finishes.
+ */
+struct FDetachedCoroutine {
+    struct promise_type {
+        FDetachedCoroutine get_return_object() noexcept { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept { std::terminate(); }
+    };
+};
+
+/** Status and converted response of a unary call, e.g. `auto [Status, Profile] = co_await ...`. */
+template <typename TResult>
+struct TCallResult {
+    grpc::Status Status;
+    TResult Value;
+};
+
+/**
+ * co_await-able unary call on the pool's completion queue. The call is prepared when the
+ * awaitable is created and sent when it is awaited; the response is converted on the polling
+ * thread and the coroutine resumes on the executor. Await it straight away: it holds the
+ * call's state and must stay where it was created.
+ */
+template <typename TProtoResponse, typename TResult>
+class TUnaryAwaitable final : private FCompletionTag {
+public:
+    using FConvert = TResult (*)(const TProtoResponse&);
+
+    /** Prepare(Context, ChannelIndex, Queue) returns the reader from the stub's PrepareAsync<Method>. */
+    template <typename TPrepare>
+    TUnaryAwaitable(FChannelPool& Pool, FExecutor& InExecutor, FConvert InConvert, const FCancellationToken& Cancellation, TPrepare&& Prepare)
+        : Executor(InExecutor), Convert(InConvert), Lease(Pool.Acquire()) {
+        Registration = Cancellation.Register(Context);
+        Reader = Prepare(&Context, Lease.GetIndex(), Pool.GetCompletionQueue());
+    }
+
+    TUnaryAwaitable(const TUnaryAwaitable&) = delete;
+    TUnaryAwaitable& operator=(const TUnaryAwaitable&) = delete;
+
+    [[nodiscard]] bool await_ready() const noexcept { return false; }
+
+    void await_suspend(std::coroutine_handle<> Handle) {
+        Resumption.Handle = Handle;
+        Reader->StartCall();
+        Reader->Finish(&Response, &Result.Status, static_cast<FCompletionTag*>(this));
+    }
+
+    TCallResult<TResult> await_resume() { return std::move(Result); }
+
+private:
+    void OnComplete(bool) override {
+        Lease.Release();
+        Registration.Reset();
+        if (Result.Status.ok()) Result.Value = Convert(Response);
+        Executor.Post(Resumption);
+    }
+
+    FExecutor& Executor;
+    const FConvert Convert;
+    FChannelPool::FLease Lease;
+    grpc::ClientContext Context;
+    FCancellationToken::FRegistration Registration;
+    std::unique_ptr<grpc::ClientAsyncResponseReader<TProtoResponse>> Reader;
+    TProtoResponse Response;
+    TCallResult<TResult> Result;
+    FResumption Resumption;
+};
+
+/** Stands in for the message type of a direction a stream doesn't have. */
+struct FNoMessage {};
+
+/**
+ * A streaming call driven by co_await on the pool's completion queue. Each operation is
+ * awaited before the next is issued: Read resumes with the converted message (or nullopt at
+ * the end of the stream), Write and WritesDone with whether the message went out, and Finish
+ * with the final status. Once anything has been awaited, await Finish before the stream goes
+ * out of scope. Like the unary awaitable, it must stay where it was created.
+ */
+template <typename TStream, typename TProtoWrite, typename TProtoRead, typename TWrite, typename TRead>
+class TStreamAwaitable final : private FCompletionTag {
+    static constexpr bool bCanWrite = !std::is_same_v<TWrite, FNoMessage>;
+    //client streams read their single response through Finish
+    static constexpr bool bCanRead = !std::is_same_v<TStream, grpc::ClientAsyncWriter<TProtoWrite>>;
+
+    enum class EOp : uint8_t { Start, Read, Write, WritesDone, Finish };
+
+public:
+    using FToProto = void (*)(const TWrite&, TProtoWrite&);
+    using FConvert = TRead (*)(const TProtoRead&);
+
+    /** Prepare(Context, ChannelIndex, Queue), plus the response to fill for client streams, returns the stream from PrepareAsync<Method>. */
+    template <typename TPrepare>
+    TStreamAwaitable(FChannelPool& Pool, FExecutor& InExecutor, FToProto InToProto, FConvert InConvert, const FCancellationToken& Cancellation, TPrepare&& Prepare)
+        : Executor(InExecutor), ToProto(InToProto), Convert(InConvert), Lease(Pool.Acquire()) {
+        Registration = Cancellation.Register(Context);
+        if constexpr (bCanRead) Stream = Prepare(&Context, Lease.GetIndex(), Pool.GetCompletionQueue());
+        else Stream = Prepare(&Context, Lease.GetIndex(), Pool.GetCompletionQueue(), &ReadBuffer);
+    }
+
+    TStreamAwaitable(const TStreamAwaitable&) = delete;
+    TStreamAwaitable& operator=(const TStreamAwaitable&) = delete;
+
+    struct FOpAwaiter {
+        TStreamAwaitable& Owner;
+        const EOp Op;
+        [[nodiscard]] bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> Handle) { Owner.Begin(Op, Handle); }
+        bool await_resume() const noexcept { return Owner.bOk; }
+    };
+
+    struct FReadAwaiter {
+        TStreamAwaitable& Owner;
+        [[nodiscard]] bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> Handle) { Owner.Begin(EOp::Read, Handle); }
+        std::optional<TRead> await_resume() {
+            if (!Owner.bOk) return std::nullopt;
+            return std::optional<TRead>(std::move(Owner.Converted));
+        }
+    };
+
+    struct FFinishAwaiter {
+        TStreamAwaitable& Owner;
+        [[nodiscard]] bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> Handle) { Owner.Begin(EOp::Finish, Handle); }
+        auto await_resume() {
+            if constexpr (bCanRead) return Owner.Status;
+            else return TCallResult<TRead>{Owner.Status, std::move(Owner.Converted)};
+        }
+    };
+
+    [[nodiscard]] FReadAwaiter Read() requires bCanRead { return {*this}; }
+
+    /** Converts the message before suspending, so Message needn't outlive the call. */
+    [[nodiscard]] FOpAwaiter Write(const TWrite& Message) requires bCanWrite {
+        WriteBuffer.Clear();
+        ToProto(Message, WriteBuffer);
+        return {*this, EOp::Write};
+    }
+
+    [[nodiscard]] FOpAwaiter WritesDone() requires bCanWrite { return {*this, EOp::WritesDone}; }
+
+    /** Resumes with the status, plus the converted response for client streams. */
+    [[nodiscard]] FFinishAwaiter Finish() { return {*this}; }
+
+private:
+    void Begin(EOp Op, std::coroutine_handle<> Handle) {
+        Pending = Op;
+        Resumption.Handle = Handle;
+        if (bStarted) {
+            Issue();
+            return;
+        }
+        bStarted = true;
+        Current = EOp::Start;
+        Stream->StartCall(static_cast<FCompletionTag*>(this));
+    }
+
+    void Issue() {
+        FCompletionTag* Tag = this;
+        Current = Pending;
+        switch (Pending) {
+            case EOp::Read:
+                if constexpr (bCanRead) Stream->Read(&ReadBuffer, Tag);
+                break;
+            case EOp::Write:
+                if constexpr (bCanWrite) Stream->Write(WriteBuffer, Tag);
+                break;
+            case EOp::WritesDone:
+                if constexpr (bCanWrite) Stream->WritesDone(Tag);
+                break;
+            case EOp::Finish:
+                Stream->Finish(&Status, Tag);
+                break;
+            case EOp::Start:
+                break;
+        }
+    }
+
+    void OnComplete(bool bInOk) override {
+        //a failed start still needs Finish issued to learn why
+        if (Current == EOp::Start && (bInOk || Pending == EOp::Finish)) {
+            Issue();
+            return;
+        }
+        bOk = bInOk && Current != EOp::Start;
+        if (Current == EOp::Read && bOk) Converted = Convert(ReadBuffer);
+        if (Current == EOp::Finish) {
+            if constexpr (!bCanRead) {
+                if (Status.ok()) Converted = Convert(ReadBuffer);
+            }
+            Lease.Release();
+            Registration.Reset();
+        }
+        Executor.Post(Resumption);
+    }
+
+    FExecutor& Executor;
+    const FToProto ToProto;
+    const FConvert Convert;
+    FChannelPool::FLease Lease;
+    grpc::ClientContext Context;
+    FCancellationToken::FRegistration Registration;
+    std::unique_ptr<TStream> Stream;
+    TProtoWrite WriteBuffer;
+    TProtoRead ReadBuffer;
+    TRead Converted{};
+    grpc::Status Status;
+    FResumption Resumption;
+    EOp Pending = EOp::Start;
+    EOp Current = EOp::Start;
+    bool bStarted = false;
+    bool bOk = false;
+};
+
+template <typename TProtoResponse, typename TResult>
+using TServerStreamAwaitable = TStreamAwaitable<grpc::ClientAsyncReader<TProtoResponse>, FNoMessage, TProtoResponse, FNoMessage, TResult>;
+
+template <typename TProtoRequest, typename TProtoResponse, typename TRequest, typename TResult>
+using TClientStreamAwaitable = TStreamAwaitable<grpc::ClientAsyncWriter<TProtoRequest>, TProtoRequest, TProtoResponse, TRequest, TResult>;
+
+template <typename TProtoRequest, typename TProtoResponse, typename TRequest, typename TResult>
+using TBidiStreamAwaitable = TStreamAwaitable<grpc::ClientAsyncReaderWriter<TProtoRequest, TProtoResponse>, TProtoRequest, TProtoResponse, TRequest, TResult>;
+
+}
@@ -0,0 +1,96 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+
+namespace UnrealGrpc {
+
+/**
+ * Fixed-size log-linear histogram in the style of HdrHistogram. Values are split into power-of-two
+ * ranges, each divided into 2^SubBucketBits linear sub-buckets, so every recorded value keeps a
+ * relative error below 1/2^SubBucketBits (~3%) without any allocation. Values are nanoseconds and
+ * saturate at 2^MaxValueBits (~18 minutes).
+ */
+class FLatencyHistogram {
+public:
+    static constexpr int32_t SubBucketBits = 5;
+    static constexpr int32_t SubBucketCount = 1 << SubBucketBits;
+    static constexpr int32_t MaxValueBits = 40;
+    static constexpr int32_t NumBuckets = (MaxValueBits - SubBucketBits + 1) * SubBucketCount;
+
+    static constexpr int32_t GetBucketIndex(uint64_t Value) {
+        Value = std::min<uint64_t>(Value, (uint64_t{1} << MaxValueBits) - 1);
+        if (Value < SubBucketCount) return static_cast<int32_t>(Value);
+        const int32_t Shift = std::bit_width(Value) - 1 - SubBucketBits;
+        return (Shift + 1) * SubBucketCount + static_cast<int32_t>((Value >> Shift) - SubBucketCount);
+    }
+
+    /** Smallest value that lands in the bucket. */
+    static constexpr uint64_t GetBucketLowerBound(int32_t Index) {
+        if (Index < SubBucketCount) return static_cast<uint64_t>(Index);
+        const int32_t Shift = Index / SubBucketCount - 1;
+        return static_cast<uint64_t>(Index % SubBucketCount + SubBucketCount) << Shift;
+    }
+
+    /** Middle of the bucket's range, which is what percentiles report. */
+    static constexpr uint64_t GetBucketMidpoint(int32_t Index) {
+        if (Index < SubBucketCount) return static_cast<uint64_t>(Index);
+        const int32_t Shift = Index / SubBucketCount - 1;
+        return GetBucketLowerBound(Index) + ((uint64_t{1} << Shift) >> 1);
+    }
+
+    void Record(uint64_t Nanos) {
+        Counts[GetBucketIndex(Nanos)]++;
+        TotalCount++;
+        Sum += Nanos;
+        Min = std::min(Min, Nanos);
+        Max = std::max(Max, Nanos);
+    }
+
+    /** Adds a whole bucket at once, used when folding in counts gathered elsewhere. */
+    void RecordBucket(int32_t Index, uint64_t Count) {
+        if (Count == 0) return;
+        Counts[Index] += Count;
+        TotalCount += Count;
+        Sum += GetBucketMidpoint(Index) * Count;
+        Min = std::min(Min, GetBucketLowerBound(Index));
+        Max = std::max(Max, GetBucketMidpoint(Index));
+    }
+
+    void Merge(const FLatencyHistogram& Other) {
+        for (int32_t i = 0; i < NumBuckets; i++) Counts[i] += Other.Counts[i];
+        TotalCount += Other.TotalCount;
+        Sum += Other.Sum;
+        Min = std::min(Min, Other.Min);
+        Max = std::max(Max, Other.Max);
+    }
+
+    void Reset() { *this = FLatencyHistogram(); }
+
+    /** Value at the given percentile in [0, 100], e.g. 99.9. */
+    [[nodiscard]] uint64_t GetPercentile(double Percentile) const {
+        if (TotalCount == 0) return 0;
+        const auto Target = std::max<uint64_t>(1, static_cast<uint64_t>(Percentile / 100.0 * static_cast<double>(TotalCount) + 0.5));
+        uint64_t Seen = 0;
+        for (int32_t i = 0; i < NumBuckets; i++) {
+            Seen += Counts[i];
+            if (Seen >= Target) return std::clamp(GetBucketMidpoint(i), Min, Max);
+        }
+        return Max;
+    }
+
+    [[nodiscard]] uint64_t GetCount() const { return TotalCount; }
+    [[nodiscard]] uint64_t GetMin() const { return TotalCount ? Min : 0; }
+    [[nodiscard]] uint64_t GetMax() const { return Max; }
+    [[nodiscard]] double GetMean() const { return TotalCount ? static_cast<double>(Sum) / static_cast<double>(TotalCount) : 0.0; }
+
+private:
+    std::array<uint64_t, NumBuckets> Counts{};
+    uint64_t TotalCount = 0;
+    uint64_t Sum = 0;
+    uint64_t Min = UINT64_MAX;
+    uint64_t Max = 0;
+};
+
+}
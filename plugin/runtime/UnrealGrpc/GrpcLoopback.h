@@ -0,0 +1,446 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <ctime>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+#include <grpcpp/grpcpp.h>
+#include "UnrealGrpc/GrpcChannelPool.h"
+#include "UnrealGrpc/GrpcRequestKey.h"
+#include "UnrealGrpc/GrpcSerialization.h"
+#include "UnrealGrpc/GrpcTrafficRecorder.h"
+#ifdef _WIN32
+//inside UE the wrapper keeps windows.h from clobbering the engine's type macros; grpc-replay has no engine
+#if __has_include("Windows/WindowsHWrapper.h")
+#include "Windows/WindowsHWrapper.h"
+#else
+#include <windows.h>
+#endif
+#endif
+
+namespace UnrealGrpc {
+
+enum class ELoopbackTransport : uint8_t {
+    /** Calls go through gRPC's in-process transport: full call path, no sockets. */
+    InProcess,
+    /** Calls go over TCP to 127.0.0.1, adding the kernel network stack and HTTP/2 framing. */
+    Localhost,
+};
+
+struct FLoopbackBenchmarkConfig {
+    ELoopbackTransport Transport = ELoopbackTransport::InProcess;
+    int32_t NumChannels = 1;
+    int32_t WarmupIterations = 100;
+    int32_t Iterations = 1000;
+};
+
+struct FLatencySummary {
+    double MeanUs = 0;
+    double P50Us = 0;
+    double P99Us = 0;
+    double MaxUs = 0;
+
+    static FLatencySummary FromSamples(std::vector<double>& SamplesUs) {
+        FLatencySummary Summary;
+        if (SamplesUs.empty()) return Summary;
+        std::sort(SamplesUs.begin(), SamplesUs.end());
+        double Total = 0;
+        for (const double Sample : SamplesUs) Total += Sample;
+        const auto Percentile = [&SamplesUs](double P) { return SamplesUs[static_cast<size_t>(P * static_cast<double>(SamplesUs.size() - 1))]; };
+        Summary.MeanUs = Total / static_cast<double>(SamplesUs.size());
+        Summary.P50Us = Percentile(0.5);
+        Summary.P99Us = Percentile(0.99);
+        Summary.MaxUs = SamplesUs.back();
+        return Summary;
+    }
+};
+
+/**
+ * Per-method output of a generated Run<Service>LoopbackBenchmark. Call covers the whole client
+ * path (ToProto, RPC, Convert); Conversion covers ToProto and Convert alone, so the difference
+ * is what the RPC itself costs. AsyncCall is the round trip of <Method>Async up to its callback,
+ * which is where the completion-queue and callback client APIs differ.
+ */
+struct FLoopbackMethodResult {
+    std::string Method;
+    /** "cq" or "callback", the client_api the client was generated with. */
+    std::string ClientApi;
+    FLatencySummary Call;
+    FLatencySummary AsyncCall;
+    FLatencySummary Conversion;
+    /** Request serialization through gRPC's own protobuf path, and into an FSerializationSlab. */
+    FLatencySummary Serialize;
+    FLatencySummary SlabSerialize;
+    /** Heap allocations per 1000 requests serialized into the slab. gRPC's path makes one per request above 23 bytes. */
+    double SlabAllocationsPerThousand = 0;
+    /** Response parsing after flattening the received buffer into one copy, and from its slices in place. */
+    FLatencySummary FlatParse;
+    FLatencySummary SliceParse;
+    /**
+     * Bytes each parse path copies out of the received slices per byte received, before protobuf reads
+     * them. Protobuf's own copies of field contents into the message come on top, the same for both.
+     */
+    double FlatParseCopiesPerByte = 0;
+    double SliceParseCopiesPerByte = 0;
+    /** CPU time of the whole process per async call, loopback server included. */
+    double AsyncCpuUs = 0;
+    int32_t FailedCalls = 0;
+};
+
+/** CPU time used so far by every thread of the process, in microseconds. */
+inline double GetProcessCpuUs() {
+#ifdef _WIN32
+    FILETIME Creation, Exit, Kernel, User;
+    if (!GetProcessTimes(GetCurrentProcess(), &Creation, &Exit, &Kernel, &User)) return 0;
+    const auto ToUs = [](const FILETIME& Time) { return static_cast<double>((static_cast<uint64_t>(Time.dwHighDateTime) << 32) | Time.dwLowDateTime) / 10.0; };
+    return ToUs(Kernel) + ToUs(User);
+#else
+    timespec Time{};
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &Time);
+    return static_cast<double>(Time.tv_sec) * 1e6 + static_cast<double>(Time.tv_nsec) / 1e3;
+#endif
+}
+
+/** Times Func over the configured iterations after a warm-up. Func returns false for a failed call. */
+template <typename TFunc>
+FLatencySummary MeasureLatency(const FLoopbackBenchmarkConfig& Config, TFunc&& Func, int32_t* OutFailures = nullptr) {
+    for (int32_t i = 0; i < Config.WarmupIterations; i++) Func();
+    std::vector<double> SamplesUs;
+    SamplesUs.reserve(Config.Iterations);
+    for (int32_t i = 0; i < Config.Iterations; i++) {
+        const auto Start = std::chrono::steady_clock::now();
+        const bool bOk = Func();
+        SamplesUs.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - Start).count());
+        if (!bOk && OutFailures) (*OutFailures)++;
+    }
+    return FLatencySummary::FromSamples(SamplesUs);
+}
+
+/** Fills the serialization results of Result by serializing Message repeatedly both ways. */
+template <typename TProto>
+void MeasureSerialization(const FLoopbackBenchmarkConfig& Config, const TProto& Message, FLoopbackMethodResult& Result) {
+    //each buffer is released straight away, as it would be once its send completes
+    Result.Serialize = MeasureLatency(Config, [&] {
+        grpc::ByteBuffer Buffer;
+        bool bOwnBuffer = false;
+        return grpc::SerializationTraits<TProto>::Serialize(Message, &Buffer, &bOwnBuffer).ok();
+    });
+    FSerializationSlab Slab;
+    Result.SlabSerialize = MeasureLatency(Config, [&] {
+        grpc::ByteBuffer Buffer;
+        SerializeToByteBuffer(Message, Slab, Buffer);
+        return true;
+    });
+    Result.SlabAllocationsPerThousand = 1000.0 * static_cast<double>(Slab.GetChunkAllocations()) / static_cast<double>(std::max<uint64_t>(Slab.GetSlices(), 1));
+}
+
+//how many of the Size bytes at Data were copied out of Slices, i.e. don't lie inside one of them
+inline size_t CountCopiedBytes(const std::vector<grpc::Slice>& Slices, const void* Data, size_t Size) {
+    const uint8_t* Begin = static_cast<const uint8_t*>(Data);
+    for (const grpc::Slice& Slice : Slices) {
+        if (Begin >= Slice.begin() && Begin + Size <= Slice.end()) return 0;
+    }
+    return Size;
+}
+
+/**
+ * Fills the parsing results of Result from Message, split into slices the size of HTTP/2 frames
+ * the way a received buffer arrives.
+ */
+template <typename TProto>
+void MeasureParsing(const FLoopbackBenchmarkConfig& Config, const TProto& Message, FLoopbackMethodResult& Result) {
+    constexpr size_t FrameBytes = 16 * 1024;
+    const std::string Bytes = Message.SerializeAsString();
+    std::vector<grpc::Slice> Slices;
+    for (size_t Offset = 0; Offset < Bytes.size(); Offset += FrameBytes) Slices.emplace_back(Bytes.data() + Offset, std::min(FrameBytes, Bytes.size() - Offset));
+    grpc::ByteBuffer Buffer(Slices.data(), Slices.size());
+    Result.FlatParse = MeasureLatency(Config, [&] {
+        grpc::Slice Flat;
+        TProto Parsed;
+        return Buffer.DumpToSingleSlice(&Flat).ok() && Parsed.ParseFromArray(Flat.begin(), static_cast<int>(Flat.size()));
+    });
+    Result.SliceParse = MeasureLatency(Config, [&] {
+        TProto Parsed;
+        return ParseFromByteBuffer(Buffer, Parsed);
+    });
+    //checks the copy each path makes against the slices themselves rather than assuming it
+    if (Bytes.empty()) return;
+    size_t FlatCopied = 0;
+    if (grpc::Slice Flat; Buffer.DumpToSingleSlice(&Flat).ok()) FlatCopied = CountCopiedBytes(Slices, Flat.begin(), Flat.size());
+    size_t SliceCopied = 0;
+    grpc::ProtoBufferReader Reader(&Buffer);
+    const void* Data = nullptr;
+    int Size = 0;
+    while (Reader.status().ok() && Reader.Next(&Data, &Size)) SliceCopied += CountCopiedBytes(Slices, Data, static_cast<size_t>(Size));
+    Result.FlatParseCopiesPerByte = static_cast<double>(FlatCopied) / static_cast<double>(Bytes.size());
+    Result.SliceParseCopiesPerByte = static_cast<double>(SliceCopied) / static_cast<double>(Bytes.size());
+}
+
+/**
+ * Hosts a single service in this process for benchmarks and tests.
+ */
+class FLoopbackServer {
+public:
+    FLoopbackServer(grpc::Service& Service, ELoopbackTransport InTransport) : Transport(InTransport) {
+        grpc::ServerBuilder Builder;
+        if (Transport == ELoopbackTransport::Localhost) Builder.AddListeningPort("127.0.0.1:0", grpc::InsecureServerCredentials(), &Port);
+        Builder.RegisterService(&Service);
+        Server = Builder.BuildAndStart();
+    }
+
+    ~FLoopbackServer() {
+        if (Server) Server->Shutdown(std::chrono::system_clock::now() + std::chrono::seconds(1));
+    }
+
+    FLoopbackServer(const FLoopbackServer&) = delete;
+    FLoopbackServer& operator=(const FLoopbackServer&) = delete;
+
+    [[nodiscard]] bool IsRunning() const { return Server != nullptr; }
+
+    /** Pool of channels to this server. Must be released before the server is destroyed. */
+    [[nodiscard]] std::shared_ptr<FChannelPool> CreatePool(int32_t NumChannels) const {
+        if (Transport == ELoopbackTransport::Localhost) {
+            FChannelPoolConfig Config;
+            Config.NumChannels = NumChannels;
+            return std::make_shared<FChannelPool>("127.0.0.1:" + std::to_string(Port), Config);
+        }
+        std::vector<std::shared_ptr<grpc::Channel>> Channels;
+        for (int32_t i = 0; i < std::max(NumChannels, 1); i++) Channels.push_back(Server->InProcessChannel(grpc::ChannelArguments()));
+        return std::make_shared<FChannelPool>(std::move(Channels));
+    }
+
+private:
+    ELoopbackTransport Transport;
+    int Port = 0;
+    std::unique_ptr<grpc::Server> Server;
+};
+
+/** Server-streaming loopback handler: writes the canned response Count times, then finishes. */
+template <typename TResponse>
+class TLoopbackWriter final : public grpc::ServerWriteReactor<TResponse> {
+public:
+    TLoopbackWriter(const TResponse& InResponse, int32_t InCount) : Response(InResponse), Remaining(InCount) { WriteNext(); }
+
+    void OnWriteDone(bool bOk) override {
+        if (!bOk) this->Finish(grpc::Status::CANCELLED);
+        else WriteNext();
+    }
+    void OnDone() override { delete this; }
+
+private:
+    void WriteNext() {
+        if (Remaining-- > 0) this->StartWrite(&Response);
+        else this->Finish(grpc::Status::OK);
+    }
+
+    const TResponse& Response;
+    int32_t Remaining;
+};
+
+/** Client-streaming loopback handler: drains every request, then answers with the canned response. */
+template <typename TRequest, typename TResponse>
+class TLoopbackReader final : public grpc::ServerReadReactor<TRequest> {
+public:
+    TLoopbackReader(TResponse* OutResponse, const TResponse& CannedResponse) {
+        *OutResponse = CannedResponse;
+        this->StartRead(&Request);
+    }
+
+    void OnReadDone(bool bOk) override {
+        if (bOk) this->StartRead(&Request);
+        else this->Finish(grpc::Status::OK);
+    }
+    void OnDone() override { delete this; }
+
+private:
+    TRequest Request;
+};
+
+/** Bidi loopback handler: answers every request, echoing it back when request and response types match. */
+template <typename TRequest, typename TResponse>
+class TLoopbackBidi final : public grpc::ServerBidiReactor<TRequest, TResponse> {
+public:
+    explicit TLoopbackBidi(const TResponse& InCannedResponse) : CannedResponse(InCannedResponse) { this->StartRead(&Request); }
+
+    void OnReadDone(bool bOk) override {
+        if (!bOk) {
+            this->Finish(grpc::Status::OK);
+            return;
+        }
+        if constexpr (std::is_same_v<TRequest, TResponse>) this->StartWrite(&Request);
+        else this->StartWrite(&CannedResponse);
+    }
+    void OnWriteDone(bool bOk) override {
+        if (bOk) this->StartRead(&Request);
+        else this->Finish(grpc::Status::CANCELLED);
+    }
+    void OnDone() override { delete this; }
+
+private:
+    TRequest Request;
+    const TResponse& CannedResponse;
+};
+
+
+struct FTrafficReplayConfig {
+    ELoopbackTransport Transport = ELoopbackTransport::InProcess;
+    int32_t NumChannels = 1;
+    /** 1 replays at the recorded pace, 4 four times as fast. 0 sends each call as soon as the one before it has gone out. */
+    double Speed = 1.0;
+};
+
+/**
+ * Per-method output of a replay. Call runs from when the call was due to its completion, so a
+ * client that falls behind the recorded pace shows up as latency. Conversion is ToProto of the
+ * recorded request plus Convert of the recorded response, timed on the replaying thread.
+ */
+struct FReplayMethodResult {
+    std::string Method;
+    int32_t Calls = 0;
+    /** Calls that ended with a different status than the recorded call. */
+    int32_t StatusMismatches = 0;
+    /** Recorded calls whose messages didn't parse as the method's current types. */
+    int32_t Skipped = 0;
+    FLatencySummary Call;
+    FLatencySummary Conversion;
+};
+
+/**
+ * Replays the recorded calls of a set of methods at their recorded pace, and answers them on a
+ * loopback server with the recorded responses. Used by the generated Replay<Service>Recording and
+ * by grpc-replay. The calls must outlive the replay.
+ */
+class FTrafficReplay {
+public:
+    /** Passed to the call made for one recorded call. Invoke it once, with the call's final status. */
+    class FCompletion {
+    public:
+        FCompletion(FTrafficReplay& InReplay, int32_t InMethod, std::chrono::steady_clock::time_point InDue, grpc::StatusCode InExpected)
+            : Replay(&InReplay), Method(InMethod), Due(InDue), Expected(InExpected) {}
+
+        void operator()(const grpc::Status& Status) const { Replay->Complete(Method, Due, Status.error_code() != Expected); }
+
+    private:
+        FTrafficReplay* Replay;
+        int32_t Method;
+        std::chrono::steady_clock::time_point Due;
+        grpc::StatusCode Expected;
+    };
+
+    /** Keeps the calls of Methods, given as paths ("/package.Service/Method"). Results come back in the same order. */
+    FTrafficReplay(const std::vector<FRecordedCall>& Calls, const std::vector<std::string>& Methods) : Results(Methods.size()), PerMethod(Methods.size()) {
+        for (size_t i = 0; i < Methods.size(); i++) Results[i].Method = Methods[i].substr(Methods[i].rfind('/') + 1);
+        for (const FRecordedCall& Call : Calls) {
+            const auto It = std::find(Methods.begin(), Methods.end(), Call.Method);
+            if (It == Methods.end()) continue;
+            const auto Method = static_cast<int32_t>(It - Methods.begin());
+            Replayed.push_back({&Call, Method});
+            FMethodState& State = PerMethod[Method];
+            State.ByRequest[Call.Request].push_back(&Call);
+            State.InOrder.push_back(&Call);
+        }
+    }
+
+    /**
+     * Loopback handler body for Method. Answers with the response recorded for the same request
+     * bytes, in recorded order when several calls sent the same request. Requests that differ
+     * from every recorded one, e.g. because map entries were reordered, take the method's
+     * recorded responses in turn.
+     */
+    grpc::Status Answer(int32_t Method, const google::protobuf::MessageLite& Request, google::protobuf::MessageLite& Response) {
+        const FRecordedCall* Call = nullptr;
+        {
+            std::lock_guard Lock(Mutex);
+            FMethodState& State = PerMethod[Method];
+            if (State.InOrder.empty()) return grpc::Status(grpc::StatusCode::NOT_FOUND, "No recorded calls");
+            const auto It = State.ByRequest.find(SerializeDeterministic(Request));
+            if (It != State.ByRequest.end()) {
+                //the last recorded answer keeps serving repeats beyond the recording
+                Call = It->second.front();
+                if (It->second.size() > 1) It->second.pop_front();
+            } else {
+                Call = State.InOrder[State.Next++ % State.InOrder.size()];
+            }
+        }
+        if (Call->Status != grpc::StatusCode::OK) return grpc::Status(Call->Status, "Recorded status");
+        return Response.ParseFromString(Call->Response) ? grpc::Status::OK : grpc::Status(grpc::StatusCode::INTERNAL, "Recorded response doesn't parse");
+    }
+
+    /** Times one conversion for Method. Only call it from inside Issue. */
+    template <typename TFunc>
+    void TimeConversion(int32_t Method, TFunc&& Func) {
+        const auto Start = std::chrono::steady_clock::now();
+        Func();
+        PerMethod[Method].ConversionUs.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - Start).count());
+    }
+
+    /**
+     * Calls Issue(Call, Method, Completion) for each recorded call when it is due, then waits for
+     * every completion. Issue returns false, without invoking Completion, to skip a call.
+     */
+    template <typename TIssue>
+    std::vector<FReplayMethodResult> Run(double Speed, TIssue&& Issue) {
+        const auto Start = std::chrono::steady_clock::now();
+        for (const auto& [Call, Method] : Replayed) {
+            auto Due = std::chrono::steady_clock::now();
+            if (Speed > 0) {
+                Due = Start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double, std::micro>(
+                    static_cast<double>(Call->Start.count()) / Speed));
+                std::this_thread::sleep_until(Due);
+            }
+            {
+                std::lock_guard Lock(Mutex);
+                Outstanding++;
+            }
+            if (Issue(*Call, Method, FCompletion(*this, Method, Due, Call->Status))) continue;
+            std::lock_guard Lock(Mutex);
+            Results[Method].Skipped++;
+            Outstanding--;
+        }
+        std::unique_lock Lock(Mutex);
+        Idle.wait(Lock, [this] { return Outstanding == 0; });
+        for (size_t i = 0; i < Results.size(); i++) {
+            Results[i].Call = FLatencySummary::FromSamples(PerMethod[i].CallUs);
+            Results[i].Conversion = FLatencySummary::FromSamples(PerMethod[i].ConversionUs);
+        }
+        return Results;
+    }
+
+private:
+    struct FMethodState {
+        std::unordered_map<std::string, std::deque<const FRecordedCall*>> ByRequest;
+        std::vector<const FRecordedCall*> InOrder;
+        size_t Next = 0;
+        std::vector<double> CallUs;
+        std::vector<double> ConversionUs;
+    };
+
+    void Complete(int32_t Method, std::chrono::steady_clock::time_point Due, bool bMismatch) {
+        const double Us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - Due).count();
+        //notify under the lock: once Outstanding hits zero, Run() may return and destroy this replay, Idle included
+        std::lock_guard Lock(Mutex);
+        Results[Method].Calls++;
+        if (bMismatch) Results[Method].StatusMismatches++;
+        PerMethod[Method].CallUs.push_back(Us);
+        Outstanding--;
+        Idle.notify_all();
+    }
+
+    std::vector<std::pair<const FRecordedCall*, int32_t>> Replayed;
+    std::vector<FReplayMethodResult> Results;
+    std::vector<FMethodState> PerMethod;
+    std::mutex Mutex;
+    std::condition_variable Idle;
+    int64_t Outstanding = 0;
+};
+
+}
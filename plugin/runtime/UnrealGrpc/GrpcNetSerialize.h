@@ -0,0 +1,147 @@
+#pragma once
+#include <bit>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include "UnrealGrpc/GrpcQuantize.h"
+
+namespace UnrealGrpc {
+
+/*
+ * Encoding used by the NetSerialize the plugin generates with net_serialize=true. Templated on the
+ * archive so this header stays free of engine includes; anything with IsLoading, Serialize,
+ * SerializeBits, IsError and SetError works, which in practice is FArchive.
+ *
+ * A struct writes one presence bit per field, set when the field differs from its default, and
+ * then only the fields whose bit is set. Floats differ from their default by bits, so -0.0 is sent
+ * and arrives as -0.0. Integers are varints, zigzagged when signed, so small
+ * negative numbers stay small. Counts and string sizes are checked when loading, so a corrupt or
+ * hostile packet fails the archive instead of allocating without bound.
+ */
+
+inline constexpr int32_t MaxNetElements = 1 << 16;
+inline constexpr int32_t MaxNetStringBytes = 1 << 16;
+
+template <typename TArchive>
+void NetSerializeVarint(TArchive& Ar, uint64_t& Value) {
+    if (Ar.IsLoading()) {
+        uint64_t Result = 0;
+        for (int Shift = 0; Shift < 64; Shift += 7) {
+            uint8_t Byte = 0;
+            Ar.Serialize(&Byte, 1);
+            if (Ar.IsError()) return;
+            Result |= static_cast<uint64_t>(Byte & 0x7F) << Shift;
+            if ((Byte & 0x80) == 0) {
+                Value = Result;
+                return;
+            }
+        }
+        //more than ten bytes can't be a varint
+        Ar.SetError();
+        return;
+    }
+    uint8_t Bytes[10];
+    int32_t Size = 0;
+    for (uint64_t Rest = Value;; Rest >>= 7) {
+        if (Rest < 0x80) {
+            Bytes[Size++] = static_cast<uint8_t>(Rest);
+            break;
+        }
+        Bytes[Size++] = static_cast<uint8_t>(Rest) | 0x80;
+    }
+    Ar.Serialize(Bytes, Size);
+}
+
+/** Integers and enums as varints. Signed types are zigzagged, so -1 takes one byte rather than ten. */
+template <typename TArchive, typename T>
+void NetSerializeInteger(TArchive& Ar, T& Value) {
+    using TInt = typename std::conditional_t<std::is_enum_v<T>, std::underlying_type<T>, std::type_identity<T>>::type;
+    using TUnsigned = std::make_unsigned_t<TInt>;
+    uint64_t Wire = 0;
+    if (!Ar.IsLoading()) {
+        const TInt Int = static_cast<TInt>(Value);
+        if constexpr (std::is_signed_v<TInt>) {
+            //in the type's own width, so an int32 -1 becomes 1 rather than a 64-bit pattern
+            Wire = static_cast<TUnsigned>(static_cast<TUnsigned>(static_cast<TUnsigned>(Int) << 1) ^ static_cast<TUnsigned>(Int >> (sizeof(TInt) * 8 - 1)));
+        } else {
+            Wire = Int;
+        }
+    }
+    NetSerializeVarint(Ar, Wire);
+    if (!Ar.IsLoading()) return;
+    if constexpr (std::is_signed_v<TInt>) {
+        Value = static_cast<T>(static_cast<TInt>(static_cast<TUnsigned>((Wire >> 1) ^ (~(Wire & 1) + 1))));
+    } else {
+        Value = static_cast<T>(static_cast<TInt>(Wire));
+    }
+}
+
+/** Whether a float or double has to be sent: any bits set, so -0.0 counts while +0.0 doesn't. */
+inline bool IsNetPresent(float Value) { return std::bit_cast<uint32_t>(Value) != 0; }
+inline bool IsNetPresent(double Value) { return std::bit_cast<uint64_t>(Value) != 0; }
+
+/** A quantized float as the varint of its step, so it costs what it would in the proto. */
+template <typename TArchive>
+void NetSerializeQuantized(TArchive& Ar, float& Value, const FQuantization& Q) {
+    uint64_t Wire = Ar.IsLoading() ? 0 : Quantize(Value, Q);
+    NetSerializeVarint(Ar, Wire);
+    if (Ar.IsLoading()) Value = Dequantize(static_cast<uint32_t>(Wire), Q);
+}
+
+/** A single bit, for bools whose presence bit doesn't already say everything. */
+template <typename TArchive>
+void NetSerializeBool(TArchive& Ar, bool& Value) {
+    uint8_t Bit = Value ? 1 : 0;
+    Ar.SerializeBits(&Bit, 1);
+    Value = (Bit & 1) != 0;
+}
+
+/** Writes Num, or reads it into Num. Returns false, failing the archive, when a count is out of range. */
+template <typename TArchive>
+bool NetSerializeCount(TArchive& Ar, int32_t& Num) {
+    uint64_t Wire = static_cast<uint64_t>(Num);
+    NetSerializeVarint(Ar, Wire);
+    if (Ar.IsError()) return false;
+    if (Wire > static_cast<uint64_t>(MaxNetElements)) {
+        Ar.SetError();
+        return false;
+    }
+    Num = static_cast<int32_t>(Wire);
+    return true;
+}
+
+template <typename TArchive, typename TArrayType, typename FSerializeElement>
+void NetSerializeArray(TArchive& Ar, TArrayType& Array, FSerializeElement SerializeElement) {
+    int32_t Num = Array.Num();
+    if (!NetSerializeCount(Ar, Num)) return;
+    if (Ar.IsLoading()) Array.SetNum(Num);
+    for (auto& Element : Array) {
+        if (Ar.IsError()) return;
+        SerializeElement(Element);
+    }
+}
+
+/** K and V are the map's key and value types. Keys are copied when saving, since the map only hands out const keys. */
+template <typename K, typename V, typename TArchive, typename TMapType, typename FSerializeKey, typename FSerializeValue>
+void NetSerializeMap(TArchive& Ar, TMapType& Map, FSerializeKey SerializeKey, FSerializeValue SerializeValue) {
+    int32_t Num = Map.Num();
+    if (!NetSerializeCount(Ar, Num)) return;
+    if (Ar.IsLoading()) {
+        Map.Empty(Num);
+        for (int32_t i = 0; i < Num && !Ar.IsError(); i++) {
+            K Key{};
+            V Value{};
+            SerializeKey(Key);
+            SerializeValue(Value);
+            Map.Add(std::move(Key), std::move(Value));
+        }
+        return;
+    }
+    for (auto& Pair : Map) {
+        K Key = Pair.Key;
+        SerializeKey(Key);
+        SerializeValue(Pair.Value);
+    }
+}
+
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <grpcpp/grpcpp.h>
+#include "UnrealGrpc/GrpcChannelPool.h"
+
+namespace UnrealGrpc {
+
+/** A blocking call made once per channel after it connects, so the first real call finds every layer warm. */
+using FWarmupCall = std::function<void(int32_t ChannelIndex, std::chrono::system_clock::time_point Deadline)>;
+
+/**
+ * Connects every channel of the pool on a background thread, paying DNS, TCP, TLS and HTTP/2
+ * setup up front instead of on the first call, then runs the warm-up calls on each channel.
+ * The future resolves to whether every channel connected before the timeout. The thread keeps
+ * the pool alive until it is done, which is never longer than Timeout.
+ */
+inline std::shared_future<bool> PrewarmPool(std::shared_ptr<FChannelPool> Pool, std::chrono::milliseconds Timeout, std::vector<FWarmupCall> WarmupCalls = {}) {
+    auto Promise = std::make_shared<std::promise<bool>>();
+    std::shared_future<bool> Result = Promise->get_future().share();
+    std::thread([Pool = std::move(Pool), Timeout, WarmupCalls = std::move(WarmupCalls), Promise] {
+        const auto Deadline = std::chrono::system_clock::now() + Timeout;
+        bool bAllConnected = true;
+        //wrapped channels such as in-process ones have no connection to start, only the warm-up calls
+        if (Pool->OwnsConnections()) {
+            //start every connection before waiting on any of them so they come up in parallel
+            for (int32_t i = 0; i < Pool->Num(); i++) Pool->GetChannel(i)->GetState(true);
+            for (int32_t i = 0; i < Pool->Num(); i++) bAllConnected &= Pool->GetChannel(i)->WaitForConnected(Deadline);
+        }
+        for (int32_t i = 0; i < Pool->Num(); i++) {
+            for (const FWarmupCall& Call : WarmupCalls) Call(i, Deadline);
+        }
+        Promise->set_value(bAllConnected);
+    }).detach();
+    return Result;
+}
+
+}
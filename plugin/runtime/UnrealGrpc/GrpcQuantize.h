@@ -0,0 +1,108 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define UNREALGRPC_QUANTIZE_SSE2 1
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define UNREALGRPC_QUANTIZE_NEON 1
+#endif
+
+namespace UnrealGrpc {
+
+/**
+ * A float field stored on the wire as a uint32 count of Precision steps above Min, set with the
+ * quantize_min, quantize_max and quantize_precision field options. The generator keeps the steps
+ * within 2^24, so every quantized value converts to a float exactly.
+ *
+ * Encoding clamps to [Min, Max] (NaN becomes Min) and rounds to the nearest step. Decoding clamps
+ * too, so a value beyond the range decodes to its nearer end. The array versions process four
+ * values per instruction with SSE2 or NEON and give the same results as the scalar ones, whose
+ * multiply-add is written to round like the vector instructions.
+ */
+struct FQuantization {
+    float Min;
+    float Max;
+    float Precision;
+};
+
+/**
+ * A * B + C, rounded the way the vector paths round it. NEON always fuses, with vfmaq_f32; elsewhere
+ * the multiply and add are separate statements, which clang's default -ffp-contract=on and MSVC
+ * never fuse, so a half-step value rounds the same in every lane and in the scalar tail.
+ */
+inline float QuantizeMultiplyAdd(float A, float B, float C) {
+#if defined(UNREALGRPC_QUANTIZE_NEON)
+    return std::fma(A, B, C);
+#else
+    const float Product = A * B;
+    return Product + C;
+#endif
+}
+
+inline uint32_t Quantize(float Value, const FQuantization& Q) {
+    //written so NaN fails both comparisons and lands on Min, as _mm_max_ps does
+    const float Clamped = std::min(Value > Q.Min ? Value : Q.Min, Q.Max);
+    return static_cast<uint32_t>(static_cast<int32_t>(QuantizeMultiplyAdd(Clamped - Q.Min, 1.0f / Q.Precision, 0.5f)));
+}
+
+inline float Dequantize(uint32_t Value, const FQuantization& Q) {
+    //read as signed like the vector paths, so a corrupt value above 2^31 clamps to Min in both
+    const float Decoded = QuantizeMultiplyAdd(static_cast<float>(static_cast<int32_t>(Value)), Q.Precision, Q.Min);
+    return std::min(std::max(Decoded, Q.Min), Q.Max);
+}
+
+inline void QuantizeArray(const float* In, uint32_t* Out, int32_t Num, const FQuantization& Q) {
+    int32_t i = 0;
+#if defined(UNREALGRPC_QUANTIZE_SSE2)
+    const __m128 Min = _mm_set1_ps(Q.Min);
+    const __m128 Max = _mm_set1_ps(Q.Max);
+    const __m128 Scale = _mm_set1_ps(1.0f / Q.Precision);
+    const __m128 Half = _mm_set1_ps(0.5f);
+    for (; i + 4 <= Num; i += 4) {
+        const __m128 Clamped = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(In + i), Min), Max);
+        const __m128 Steps = _mm_add_ps(_mm_mul_ps(_mm_sub_ps(Clamped, Min), Scale), Half);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(Out + i), _mm_cvttps_epi32(Steps));
+    }
+#elif defined(UNREALGRPC_QUANTIZE_NEON)
+    const float32x4_t Min = vdupq_n_f32(Q.Min);
+    const float32x4_t Max = vdupq_n_f32(Q.Max);
+    const float32x4_t Scale = vdupq_n_f32(1.0f / Q.Precision);
+    const float32x4_t Half = vdupq_n_f32(0.5f);
+    for (; i + 4 <= Num; i += 4) {
+        //the nm variants return the number when the other operand is NaN
+        const float32x4_t Clamped = vminnmq_f32(vmaxnmq_f32(vld1q_f32(In + i), Min), Max);
+        const float32x4_t Steps = vfmaq_f32(Half, vsubq_f32(Clamped, Min), Scale);
+        vst1q_u32(Out + i, vreinterpretq_u32_s32(vcvtq_s32_f32(Steps)));
+    }
+#endif
+    for (; i < Num; i++) Out[i] = Quantize(In[i], Q);
+}
+
+inline void DequantizeArray(const uint32_t* In, float* Out, int32_t Num, const FQuantization& Q) {
+    int32_t i = 0;
+#if defined(UNREALGRPC_QUANTIZE_SSE2)
+    const __m128 Min = _mm_set1_ps(Q.Min);
+    const __m128 Max = _mm_set1_ps(Q.Max);
+    const __m128 Precision = _mm_set1_ps(Q.Precision);
+    for (; i + 4 <= Num; i += 4) {
+        const __m128 Steps = _mm_cvtepi32_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(In + i)));
+        const __m128 Decoded = _mm_add_ps(_mm_mul_ps(Steps, Precision), Min);
+        _mm_storeu_ps(Out + i, _mm_min_ps(_mm_max_ps(Decoded, Min), Max));
+    }
+#elif defined(UNREALGRPC_QUANTIZE_NEON)
+    const float32x4_t Min = vdupq_n_f32(Q.Min);
+    const float32x4_t Max = vdupq_n_f32(Q.Max);
+    const float32x4_t Precision = vdupq_n_f32(Q.Precision);
+    for (; i + 4 <= Num; i += 4) {
+        const float32x4_t Steps = vcvtq_f32_s32(vreinterpretq_s32_u32(vld1q_u32(In + i)));
+        const float32x4_t Decoded = vfmaq_f32(Min, Steps, Precision);
+        vst1q_f32(Out + i, vminq_f32(vmaxq_f32(Decoded, Min), Max));
+    }
+#endif
+    for (; i < Num; i++) Out[i] = Dequantize(In[i], Q);
+}
+
+}
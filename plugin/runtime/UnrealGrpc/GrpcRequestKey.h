@@ -0,0 +1,25 @@
+#pragma once
+#include <string>
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/io/zero_copy_stream_impl_lite.h>
+#include <google/protobuf/message_lite.h>
+
+namespace UnrealGrpc {
+
+/**
+ * Serializes with deterministic map ordering, so equal requests always produce equal bytes
+ * and can be used as a coalescing or cache key.
+ */
+inline std::string SerializeDeterministic(const google::protobuf::MessageLite& Message) {
+    //size the key once instead of letting the string grow as the serializer writes
+    std::string Out(Message.ByteSizeLong(), '\0');
+    {
+        google::protobuf::io::ArrayOutputStream Stream(Out.data(), static_cast<int>(Out.size()));
+        google::protobuf::io::CodedOutputStream Coded(&Stream);
+        Coded.SetSerializationDeterministic(true);
+        Message.SerializeWithCachedSizes(&Coded);
+    }
+    return Out;
+}
+
+}
@@ -0,0 +1,243 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <vector>
+#include <grpcpp/alarm.h>
+#include <grpcpp/grpcpp.h>
+#include "UnrealGrpc/GrpcChannelPool.h"
+#include "UnrealGrpc/GrpcClientStats.h"
+
+namespace UnrealGrpc {
+
+/**
+ * Retry settings for one method. Only UNAVAILABLE is retried: it is the one status gRPC guarantees
+ * means the server never acted on the request.
+ */
+struct FCallPolicy {
+    /** Attempts in total, including the first and any hedge. 1 disables retries. */
+    int32_t MaxAttempts = 1;
+    std::chrono::milliseconds InitialBackoff{50};
+    std::chrono::milliseconds MaxBackoff{1000};
+
+    [[nodiscard]] static bool IsRetryable(const grpc::Status& Status) {
+        return Status.error_code() == grpc::StatusCode::UNAVAILABLE;
+    }
+
+    /** Exponential backoff with full jitter, so clients that failed together don't retry together. */
+    [[nodiscard]] std::chrono::milliseconds GetBackoff(int32_t Retry) const {
+        const int64_t Ceiling = std::min<int64_t>(MaxBackoff.count(), InitialBackoff.count() << std::min(Retry, 20));
+        thread_local std::minstd_rand Random(std::random_device{}());
+        return std::chrono::milliseconds(std::uniform_int_distribution<int64_t>(0, std::max<int64_t>(Ceiling, 0))(Random));
+    }
+};
+
+/**
+ * How long to wait before hedging: a percentile of the method's recent wire latency, never below
+ * MinDelay. The percentile is recomputed from FMethodStats at most once a second, and MinDelay is
+ * used until enough calls have been recorded, which needs a pool from the generated CreatePool.
+ */
+class FHedgeDelay {
+public:
+    static constexpr uint64_t MinSamples = 100;
+
+    FHedgeDelay(FMethodStats& InStats, double InPercentile, std::chrono::milliseconds InMinDelay)
+        : Stats(InStats), Percentile(InPercentile), MinDelay(InMinDelay), CachedNanos(ToNanos(InMinDelay)) {}
+
+    [[nodiscard]] std::chrono::nanoseconds Get() {
+        const int64_t Now = std::chrono::steady_clock::now().time_since_epoch().count();
+        int64_t Refresh = NextRefresh.load(std::memory_order_relaxed);
+        //one caller per second pays for the snapshot, everyone else reads the cached value
+        if (Now >= Refresh && NextRefresh.compare_exchange_strong(Refresh, Now + std::chrono::steady_clock::duration(std::chrono::seconds(1)).count())) {
+            const FMethodStatsSnapshot Snapshot = Stats.Snapshot();
+            const uint64_t Nanos = Snapshot.Wire.GetCount() >= MinSamples ? Snapshot.Wire.GetPercentile(Percentile) : 0;
+            CachedNanos.store(std::max(Nanos, ToNanos(MinDelay)), std::memory_order_relaxed);
+        }
+        return std::chrono::nanoseconds(CachedNanos.load(std::memory_order_relaxed));
+    }
+
+private:
+    static uint64_t ToNanos(std::chrono::milliseconds Value) {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(Value).count());
+    }
+
+    FMethodStats& Stats;
+    const double Percentile;
+    const std::chrono::milliseconds MinDelay;
+    std::atomic<uint64_t> CachedNanos;
+    std::atomic<int64_t> NextRefresh{0};
+};
+
+/**
+ * A unary call that may take several attempts on the pool's completion queue: a hedge sent when
+ * the first attempt is slower than HedgeAfter, and retries with backoff after retryable failures.
+ * The first attempt to finish with a final status wins; the others are cancelled. Deletes itself
+ * once every attempt and timer has come back. Once the pool is being destroyed no retry or hedge is
+ * sent, and the call finishes with the last attempt's status.
+ */
+template <typename TResponse>
+class TResilientCall {
+public:
+    using FStartAttempt = std::function<std::unique_ptr<grpc::ClientAsyncResponseReader<TResponse>>(
+        grpc::ClientContext*, const FChannelPool::FLease&, grpc::CompletionQueue*)>;
+    using FOnDone = std::function<void(const grpc::Status&, const TResponse&)>;
+
+    /** HedgeAfter of zero disables hedging. Cancelling the token cancels every attempt, including retries not yet sent. */
+    static void Start(FChannelPool& Pool, const FCallPolicy& Policy, std::chrono::nanoseconds HedgeAfter, FStartAttempt&& StartAttempt, FOnDone&& OnDone,
+        const FCancellationToken& Cancellation = {}) {
+        auto* Call = new TResilientCall(Pool, Policy, std::move(StartAttempt), std::move(OnDone), Cancellation);
+        {
+            std::lock_guard Lock(Call->Mutex);
+            if (Call->StartAttempt()) {
+                if (HedgeAfter.count() > 0 && Policy.MaxAttempts > 1) Call->HedgeTimer = Call->SetTimer(HedgeAfter, true);
+                return;
+            }
+        }
+        FResult Result{std::move(Call->OnDone), grpc::Status(grpc::StatusCode::CANCELLED, "channel pool is shutting down"), TResponse()};
+        delete Call;
+        Result.Run();
+    }
+
+private:
+    struct FAttempt final : FCompletionTag {
+        TResilientCall* Owner = nullptr;
+        grpc::ClientContext Context;
+        FCancellationToken::FRegistration Registration;
+        FChannelPool::FLease Lease;
+        std::unique_ptr<grpc::ClientAsyncResponseReader<TResponse>> Reader;
+        TResponse Response;
+        grpc::Status Status;
+        void OnComplete(bool) override { Owner->OnAttemptDone(*this); }
+    };
+
+    struct FTimer final : FCompletionTag {
+        TResilientCall* Owner = nullptr;
+        grpc::Alarm Alarm;
+        bool bHedge = false;
+        void OnComplete(bool bFired) override { Owner->OnTimer(*this, bFired); }
+    };
+
+    //the winner's result, handed to OnDone once the lock is released so OnDone can start other calls
+    struct FResult {
+        FOnDone OnDone;
+        grpc::Status Status;
+        TResponse Response;
+
+        void Run() {
+            if (OnDone) OnDone(Status, Response);
+        }
+    };
+
+    TResilientCall(FChannelPool& InPool, const FCallPolicy& InPolicy, FStartAttempt&& InStartAttempt, FOnDone&& InOnDone, const FCancellationToken& InCancellation)
+        : Pool(InPool), Policy(InPolicy), MakeReader(std::move(InStartAttempt)), OnDone(std::move(InOnDone)), Cancellation(InCancellation) {}
+
+    //returns false, starting nothing, once the pool is being destroyed
+    bool StartAttempt() {
+        return Pool.RunIfOpen([this] {
+            auto& Attempt = *Attempts.emplace_back(std::make_unique<FAttempt>());
+            Attempt.Owner = this;
+            //a retry started after cancellation is cancelled as it registers and comes straight back
+            Attempt.Registration = Cancellation.Register(Attempt.Context);
+            Attempt.Lease = Pool.Acquire();
+            Attempt.Reader = MakeReader(&Attempt.Context, Attempt.Lease, Pool.GetCompletionQueue());
+            Attempt.Reader->StartCall();
+            Attempt.Reader->Finish(&Attempt.Response, &Attempt.Status, &Attempt);
+            InFlight++;
+        });
+    }
+
+    //returns null, setting nothing, once the pool is being destroyed
+    FTimer* SetTimer(std::chrono::nanoseconds Delay, bool bHedge) {
+        FTimer* Timer = nullptr;
+        Pool.RunIfOpen([&] {
+            Timer = Timers.emplace_back(std::make_unique<FTimer>()).get();
+            Timer->Owner = this;
+            Timer->bHedge = bHedge;
+            Timer->Alarm.Set(Pool.GetCompletionQueue(), std::chrono::system_clock::now() + Delay, Timer);
+            PendingTimers++;
+        });
+        return Timer;
+    }
+
+    void Finish(FAttempt& Winner, FResult& Result) {
+        bFinished = true;
+        for (const auto& Attempt : Attempts) {
+            if (Attempt.get() != &Winner) Attempt->Context.TryCancel();
+        }
+        for (const auto& Timer : Timers) Timer->Alarm.Cancel();
+        Result.OnDone = std::move(OnDone);
+        Result.Status = Winner.Status;
+        Result.Response = std::move(Winner.Response);
+        //the factory holds the request for retries; free it now rather than when the losers come back
+        MakeReader = nullptr;
+        OnDone = nullptr;
+    }
+
+    void OnAttemptDone(FAttempt& Attempt) {
+        bool bDelete = false;
+        FResult Result;
+        {
+            std::lock_guard Lock(Mutex);
+            InFlight--;
+            Attempt.Lease.Release();
+            Attempt.Registration.Reset();
+            const bool bAttemptsLeft = static_cast<int32_t>(Attempts.size()) < Policy.MaxAttempts;
+            if (bFinished) {
+                //a cancelled loser coming back
+            } else if (Attempt.Status.ok() || !FCallPolicy::IsRetryable(Attempt.Status) || (!bAttemptsLeft && InFlight == 0)) {
+                Finish(Attempt, Result);
+            } else if (bAttemptsLeft && InFlight == 0) {
+                //a hedge is pointless once nothing is in flight, the retry replaces it
+                if (HedgeTimer) HedgeTimer->Alarm.Cancel();
+                HedgeTimer = nullptr;
+                if (!SetTimer(Policy.GetBackoff(Retries++), false)) Finish(Attempt, Result);
+            }
+            bDelete = IsComplete();
+        }
+        Result.Run();
+        if (bDelete) delete this;
+    }
+
+    void OnTimer(FTimer& Timer, bool bFired) {
+        bool bDelete = false;
+        FResult Result;
+        {
+            std::lock_guard Lock(Mutex);
+            PendingTimers--;
+            if (&Timer == HedgeTimer) HedgeTimer = nullptr;
+            const bool bAttemptsLeft = static_cast<int32_t>(Attempts.size()) < Policy.MaxAttempts;
+            //a hedge only makes sense while the original is still running
+            const bool bStarted = bFired && !bFinished && bAttemptsLeft && (!Timer.bHedge || InFlight > 0) && StartAttempt();
+            //a retry that couldn't be sent leaves nothing in flight to finish the call, so the last failure stands
+            if (!bStarted && !bFinished && !Timer.bHedge && InFlight == 0) Finish(*Attempts.back(), Result);
+            bDelete = IsComplete();
+        }
+        Result.Run();
+        if (bDelete) delete this;
+    }
+
+    [[nodiscard]] bool IsComplete() const { return bFinished && InFlight == 0 && PendingTimers == 0; }
+
+    FChannelPool& Pool;
+    const FCallPolicy Policy;
+    FStartAttempt MakeReader;
+    FOnDone OnDone;
+    const FCancellationToken Cancellation;
+
+    std::mutex Mutex;
+    std::vector<std::unique_ptr<FAttempt>> Attempts;
+    std::vector<std::unique_ptr<FTimer>> Timers;
+    FTimer* HedgeTimer = nullptr;
+    int32_t InFlight = 0;
+    int32_t PendingTimers = 0;
+    int32_t Retries = 0;
+    bool bFinished = false;
+};
+
+}
@@ -0,0 +1,97 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <list>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include "UnrealGrpc/GrpcRequestKey.h"
+
+namespace UnrealGrpc {
+
+/**
+ * Least-recently-used cache of converted responses with a fixed time to live. Keys are the
+ * deterministic serialized requests. Memory is bounded by both an entry count and a byte budget;
+ * an entry is charged for its key, the response struct, and the wire size of the response as an
+ * estimate of the heap the converted struct holds.
+ */
+template <typename TResponse>
+class TResponseCache {
+public:
+    static constexpr size_t DefaultMaxBytes = 1024 * 1024;
+
+    TResponseCache(std::chrono::milliseconds InTtl, size_t InMaxEntries, size_t InMaxBytes = DefaultMaxBytes)
+        : Ttl(InTtl), MaxEntries(InMaxEntries > 0 ? InMaxEntries : 1), MaxBytes(InMaxBytes) {}
+
+    TResponseCache(const TResponseCache&) = delete;
+    TResponseCache& operator=(const TResponseCache&) = delete;
+
+    /** Copies the cached response for Key into OutResponse if there is one that hasn't expired. */
+    bool Find(const std::string& Key, TResponse& OutResponse) {
+        std::lock_guard Lock(Mutex);
+        const auto It = Index.find(std::string_view(Key));
+        if (It == Index.end()) return false;
+        if (std::chrono::steady_clock::now() >= It->second->Expiry) {
+            Remove(It->second);
+            return false;
+        }
+        Entries.splice(Entries.begin(), Entries, It->second);
+        OutResponse = It->second->Response;
+        return true;
+    }
+
+    void Add(const std::string& Key, const TResponse& Response, size_t ResponseWireBytes) {
+        const size_t Cost = Key.size() + sizeof(TResponse) + ResponseWireBytes;
+        if (Cost > MaxBytes) return;
+        std::lock_guard Lock(Mutex);
+        if (const auto It = Index.find(std::string_view(Key)); It != Index.end()) Remove(It->second);
+        while (!Entries.empty() && (Entries.size() >= MaxEntries || Bytes + Cost > MaxBytes)) Remove(std::prev(Entries.end()));
+        Entries.push_front({Key, Response, std::chrono::steady_clock::now() + Ttl, Cost});
+        Index.emplace(std::string_view(Entries.front().Key), Entries.begin());
+        Bytes += Cost;
+    }
+
+    void Clear() {
+        std::lock_guard Lock(Mutex);
+        Index.clear();
+        Entries.clear();
+        Bytes = 0;
+    }
+
+    [[nodiscard]] size_t Num() const {
+        std::lock_guard Lock(Mutex);
+        return Entries.size();
+    }
+
+    [[nodiscard]] size_t GetBytes() const {
+        std::lock_guard Lock(Mutex);
+        return Bytes;
+    }
+
+private:
+    struct FEntry {
+        std::string Key;
+        TResponse Response;
+        std::chrono::steady_clock::time_point Expiry;
+        size_t Cost;
+    };
+    using FEntryIterator = typename std::list<FEntry>::iterator;
+
+    void Remove(FEntryIterator It) {
+        Bytes -= It->Cost;
+        Index.erase(std::string_view(It->Key));
+        Entries.erase(It);
+    }
+
+    const std::chrono::milliseconds Ttl;
+    const size_t MaxEntries;
+    const size_t MaxBytes;
+    mutable std::mutex Mutex;
+    //most recently used at the front; the index views keys owned by the list nodes, which never move
+    std::list<FEntry> Entries;
+    std::unordered_map<std::string_view, FEntryIterator> Index;
+    size_t Bytes = 0;
+};
+
+}
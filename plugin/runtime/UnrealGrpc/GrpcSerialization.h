@@ -0,0 +1,175 @@
+#pragma once
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <string>
+#include <vector>
+#include <grpcpp/grpcpp.h>
+#include <grpcpp/support/proto_buffer_reader.h>
+#include <google/protobuf/message_lite.h>
+
+namespace UnrealGrpc {
+
+/**
+ * Reusable memory for outbound messages. Each message gets one exact-size slice carved out of a
+ * shared chunk, so a send costs no buffer allocation of its own; chunks go back to the slab when
+ * gRPC has released every slice in them and are handed out again. Large messages get a slice
+ * of their own. Not thread-safe: give each sending thread its own slab. Slices may be released
+ * on any thread and may outlive the slab.
+ */
+class FSerializationSlab {
+    struct FPool {
+        std::mutex Mutex;
+        std::vector<void*> Free;
+        int32_t MaxFreeChunks = 0;
+
+        ~FPool() {
+            for (void* Chunk : Free) std::free(Chunk);
+        }
+    };
+
+    //lives at the start of each chunk, in front of the message bytes
+    struct FChunkHeader {
+        std::shared_ptr<FPool> Pool;
+    };
+
+public:
+    explicit FSerializationSlab(size_t InChunkBytes = 64 * 1024, int32_t MaxFreeChunks = 8)
+        : ChunkBytes(InChunkBytes), Pool(std::make_shared<FPool>()) {
+        Pool->MaxFreeChunks = MaxFreeChunks;
+    }
+
+    FSerializationSlab(const FSerializationSlab&) = delete;
+    FSerializationSlab& operator=(const FSerializationSlab&) = delete;
+
+    /**
+     * Returns a slice of exactly Size bytes after Fill(uint8_t* Data) has written them. Filling
+     * before slicing matters: gRPC copies slices too small to share into the slice itself.
+     */
+    template <typename TFill>
+    grpc::Slice Write(size_t Size, TFill&& Fill) {
+        Slices++;
+        if (Size > ChunkBytes / 4) {
+            //a large message would waste most of a chunk, and gets one exact allocation instead
+            grpc::Slice Own(Size);
+            Fill(const_cast<uint8_t*>(Own.begin()));
+            return Own;
+        }
+        if (!Chunk.size() || Offset + Size > Chunk.size()) NextChunk();
+        uint8_t* Data = const_cast<uint8_t*>(Chunk.begin()) + Offset;
+        Fill(Data);
+        grpc::Slice Out = Chunk.sub(Offset, Offset + Size);
+        Offset += Size;
+        return Out;
+    }
+
+    /** Chunks taken from the heap, as opposed to reused. Each is one allocation. */
+    [[nodiscard]] uint64_t GetChunkAllocations() const { return ChunkAllocations; }
+
+    /** Slices handed out by Write. */
+    [[nodiscard]] uint64_t GetSlices() const { return Slices; }
+
+private:
+    void NextChunk() {
+        void* Memory = nullptr;
+        {
+            std::lock_guard Lock(Pool->Mutex);
+            if (!Pool->Free.empty()) {
+                Memory = Pool->Free.back();
+                Pool->Free.pop_back();
+            }
+        }
+        if (!Memory) {
+            Memory = std::malloc(sizeof(FChunkHeader) + ChunkBytes);
+            if (!Memory) throw std::bad_alloc();
+            ChunkAllocations++;
+        }
+        new (Memory) FChunkHeader{Pool};
+        //replacing Chunk drops the slab's reference to the previous one
+        Chunk = grpc::Slice(static_cast<uint8_t*>(Memory) + sizeof(FChunkHeader), ChunkBytes, &ReleaseChunk, Memory);
+        Offset = 0;
+    }
+
+    static void ReleaseChunk(void* Memory) {
+        FChunkHeader* Header = static_cast<FChunkHeader*>(Memory);
+        const std::shared_ptr<FPool> Owner = std::move(Header->Pool);
+        Header->~FChunkHeader();
+        {
+            std::lock_guard Lock(Owner->Mutex);
+            if (static_cast<int32_t>(Owner->Free.size()) < Owner->MaxFreeChunks) {
+                Owner->Free.push_back(Memory);
+                return;
+            }
+        }
+        std::free(Memory);
+    }
+
+    const size_t ChunkBytes;
+    std::shared_ptr<FPool> Pool;
+    grpc::Slice Chunk;
+    size_t Offset = 0;
+    uint64_t ChunkAllocations = 0;
+    uint64_t Slices = 0;
+};
+
+/**
+ * Serializes Message into a single exact-size slice from Slab. ByteSizeLong runs once and the
+ * serializer writes straight into the slice with the sizes it cached.
+ */
+inline void SerializeToByteBuffer(const google::protobuf::MessageLite& Message, FSerializationSlab& Slab, grpc::ByteBuffer& Out) {
+    const size_t Size = Message.ByteSizeLong();
+    grpc::Slice Slice = Slab.Write(Size, [&Message](uint8_t* Data) { Message.SerializeWithCachedSizesToArray(Data); });
+    grpc::ByteBuffer Buffer(&Slice, 1);
+    Out.Swap(&Buffer);
+}
+
+/**
+ * Parses Message from the slices of Buffer where they lie, without flattening them into one
+ * contiguous copy first. Only bytes that straddle two slices are copied, a few at a time.
+ */
+inline bool ParseFromByteBuffer(grpc::ByteBuffer& Buffer, google::protobuf::MessageLite& Message) {
+    grpc::ProtoBufferReader Reader(&Buffer);
+    return Reader.status().ok() && Message.ParseFromZeroCopyStream(&Reader);
+}
+
+/** How interceptors read a received message that isn't protobuf, such as a USTRUCT read by its TWireCodec. */
+struct FRecvCodec {
+    uint64_t (*Size)(const void* Message);
+    void (*Serialize)(const void* Message, std::string& Out);
+};
+
+/**
+ * Tells interceptors how to read the responses of calls created on this thread while in scope.
+ * Interceptors are created with the call, so calls whose messages aren't protobuf must be
+ * created inside one.
+ */
+class FScopedRecvCodec {
+public:
+    explicit FScopedRecvCodec(const FRecvCodec& Codec) : Previous(Current) { Current = &Codec; }
+    ~FScopedRecvCodec() { Current = Previous; }
+
+    FScopedRecvCodec(const FScopedRecvCodec&) = delete;
+    FScopedRecvCodec& operator=(const FScopedRecvCodec&) = delete;
+
+    /** The codec in scope, or null for protobuf messages. */
+    static const FRecvCodec* Get() { return Current; }
+
+private:
+    static inline thread_local const FRecvCodec* Current = nullptr;
+    const FRecvCodec* Previous;
+};
+
+/** Size of a received message, which is protobuf unless Codec is set. */
+inline uint64_t GetRecvSize(const FRecvCodec* Codec, const void* Message) {
+    return Codec ? Codec->Size(Message) : static_cast<const google::protobuf::MessageLite*>(Message)->ByteSizeLong();
+}
+
+/** Wire bytes of a received message, which is protobuf unless Codec is set. */
+inline void SerializeRecv(const FRecvCodec* Codec, const void* Message, std::string& Out) {
+    if (Codec) Codec->Serialize(Message, Out);
+    else static_cast<const google::protobuf::MessageLite*>(Message)->SerializeToString(&Out);
+}
+
+}
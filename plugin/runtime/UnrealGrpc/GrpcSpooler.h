@@ -0,0 +1,350 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <grpcpp/grpcpp.h>
+
+namespace UnrealGrpc {
+
+/**
+ * Fixed-size queue that producers on any thread push to without taking a lock: each slot carries
+ * a sequence number saying whose turn it is, and a push claims one with a single compare-exchange.
+ * Only one thread may pop.
+ */
+template <typename T>
+class TBoundedQueue {
+public:
+    explicit TBoundedQueue(size_t MinCapacity) {
+        size_t Capacity = 2;
+        while (Capacity < MinCapacity) Capacity <<= 1;
+        Slots = std::make_unique<FSlot[]>(Capacity);
+        Mask = Capacity - 1;
+        for (size_t i = 0; i < Capacity; i++) Slots[i].Sequence.store(i, std::memory_order_relaxed);
+    }
+
+    /** Returns false, leaving Value untouched, when the queue is full. */
+    bool Push(T&& Value) {
+        size_t Position = Tail.load(std::memory_order_relaxed);
+        for (;;) {
+            FSlot& Slot = Slots[Position & Mask];
+            const size_t Sequence = Slot.Sequence.load(std::memory_order_acquire);
+            const intptr_t Lag = static_cast<intptr_t>(Sequence) - static_cast<intptr_t>(Position);
+            if (Lag == 0) {
+                if (Tail.compare_exchange_weak(Position, Position + 1, std::memory_order_relaxed)) {
+                    Slot.Value = std::move(Value);
+                    Slot.Sequence.store(Position + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (Lag < 0) {
+                //the consumer hasn't freed this slot from the previous lap
+                return false;
+            } else {
+                Position = Tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /** Consumer thread only. */
+    bool Pop(T& Out) {
+        FSlot& Slot = Slots[Head & Mask];
+        if (Slot.Sequence.load(std::memory_order_acquire) != Head + 1) return false;
+        Out = std::move(Slot.Value);
+        Slot.Sequence.store(Head + Mask + 1, std::memory_order_release);
+        Head++;
+        return true;
+    }
+
+private:
+    struct FSlot {
+        std::atomic<size_t> Sequence;
+        T Value;
+    };
+
+    std::unique_ptr<FSlot[]> Slots;
+    size_t Mask = 0;
+    alignas(64) std::atomic<size_t> Tail{0};
+    alignas(64) size_t Head = 0;
+};
+
+struct FSpoolConfig {
+    /** Events per call. A full batch is sent as soon as it fills. */
+    int32_t BatchSize = 64;
+    /** Longest a queued event waits for its batch to fill. */
+    std::chrono::milliseconds FlushInterval{100};
+    /** Events held in memory. Events queued while it is full are dropped. */
+    int32_t Capacity = 8192;
+    /** Deadline for each batch call, so an unreachable server can't stall the sender. */
+    std::chrono::milliseconds SendTimeout{5000};
+    /** After a batch fails to reach the server, batches go straight to disk for this long before it is tried again. */
+    std::chrono::milliseconds RetryInterval{5000};
+    /** Append-only file that batches go to while the server can't be reached. Empty disables spilling. */
+    std::string SpillPath;
+    /** The spill file stops growing at this size, and later batches are dropped. */
+    uint64_t MaxSpillBytes = 64ull << 20;
+};
+
+/**
+ * Batches fire-and-forget events, usually telemetry, into one call per BatchSize events or per
+ * FlushInterval, whichever comes first. Enqueue never blocks or locks, so it is safe on the game
+ * thread. A background thread converts and sends the batches. Batches that fail with a status
+ * that means the server wasn't reached go to SpillPath, and are replayed oldest first once a send
+ * succeeds again, including after a restart. Replays can duplicate a batch whose call timed out
+ * after the server handled it, so delivery is at least once.
+ */
+template <typename TEvent, typename TProto>
+class TSpooler {
+public:
+    using FConvert = void (*)(const TEvent&, TProto&);
+    /** Sends the whole batch in one call. May reorder or move from the batch, but must leave the events in it. */
+    using FSend = std::function<grpc::Status(std::vector<TProto>& Batch, std::chrono::system_clock::time_point Deadline)>;
+
+    TSpooler(const FSpoolConfig& InConfig, FConvert InConvert, FSend InSend)
+        : Config(Sanitize(InConfig)), Convert(InConvert), Send(std::move(InSend)), Queue(static_cast<size_t>(Config.Capacity)) {
+        if (!Config.SpillPath.empty()) {
+            //a spill left by an earlier run is replayed with the first batch
+            std::error_code Error;
+            std::filesystem::create_directories(std::filesystem::path(Config.SpillPath).parent_path(), Error);
+            const uintmax_t Size = std::filesystem::file_size(Config.SpillPath, Error);
+            SpillBytes = Error ? 0 : static_cast<uint64_t>(Size);
+        }
+        Thread = std::thread([this] { Run(); });
+    }
+
+    /** Sends or spills everything still queued before returning. */
+    ~TSpooler() {
+        {
+            std::lock_guard Lock(Mutex);
+            bStopping = true;
+        }
+        Wake.notify_one();
+        Thread.join();
+    }
+
+    TSpooler(const TSpooler&) = delete;
+    TSpooler& operator=(const TSpooler&) = delete;
+
+    /** Queues Event without blocking. Returns false, dropping it, when the queue is full. */
+    bool Enqueue(TEvent&& Event) {
+        if (!Queue.Push(std::move(Event))) {
+            Dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        //only the event that fills a batch wakes the sender. A wake it misses costs at most one FlushInterval
+        if (Pending.fetch_add(1, std::memory_order_relaxed) + 1 == Config.BatchSize) Wake.notify_one();
+        return true;
+    }
+
+    /** Sends whatever is queued now instead of waiting for the batch to fill, e.g. before a level change. */
+    void Flush() {
+        {
+            std::lock_guard Lock(Mutex);
+            bFlushRequested = true;
+        }
+        Wake.notify_one();
+    }
+
+    /** Events delivered to the server, including replayed ones. */
+    [[nodiscard]] uint64_t GetSent() const { return Sent.load(std::memory_order_relaxed); }
+    /** Calls made, one per batch. */
+    [[nodiscard]] uint64_t GetBatches() const { return Batches.load(std::memory_order_relaxed); }
+    /** Events written to the spill file. */
+    [[nodiscard]] uint64_t GetSpilled() const { return Spilled.load(std::memory_order_relaxed); }
+    /** Events delivered from the spill file. */
+    [[nodiscard]] uint64_t GetReplayed() const { return Replayed.load(std::memory_order_relaxed); }
+    /** Events lost to a full queue, a full or disabled spill file, or a failed spill write. */
+    [[nodiscard]] uint64_t GetDropped() const { return Dropped.load(std::memory_order_relaxed); }
+    /** Events in batches the server answered with an error other than being unreachable. They are not retried. */
+    [[nodiscard]] uint64_t GetRejected() const { return Rejected.load(std::memory_order_relaxed); }
+
+private:
+    static FSpoolConfig Sanitize(FSpoolConfig Config) {
+        Config.BatchSize = std::max(Config.BatchSize, 1);
+        Config.Capacity = std::max(Config.Capacity, Config.BatchSize);
+        return Config;
+    }
+
+    //statuses where the server most likely never saw the batch, or asked to be called back later
+    static bool IsUnreachable(const grpc::Status& Status) {
+        switch (Status.error_code()) {
+        case grpc::StatusCode::UNAVAILABLE:
+        case grpc::StatusCode::DEADLINE_EXCEEDED:
+        case grpc::StatusCode::RESOURCE_EXHAUSTED:
+        case grpc::StatusCode::ABORTED:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    void Run() {
+        std::vector<TProto> Batch;
+        for (;;) {
+            bool bStop;
+            {
+                std::unique_lock Lock(Mutex);
+                Wake.wait_for(Lock, Config.FlushInterval, [this] {
+                    return bStopping || bFlushRequested || Pending.load(std::memory_order_relaxed) >= Config.BatchSize;
+                });
+                bStop = bStopping;
+                bFlushRequested = false;
+            }
+            while (Take(Batch)) Deliver(Batch);
+            //a spill also drains while no new events arrive
+            if (!bStop && SpillBytes > 0 && std::chrono::steady_clock::now() >= RetryAt) ReplaySpill();
+            if (bStop) return;
+        }
+    }
+
+    bool Take(std::vector<TProto>& Batch) {
+        Batch.clear();
+        TEvent Event;
+        while (static_cast<int32_t>(Batch.size()) < Config.BatchSize && Queue.Pop(Event)) Convert(Event, Batch.emplace_back());
+        Pending.fetch_sub(static_cast<int32_t>(Batch.size()), std::memory_order_relaxed);
+        return !Batch.empty();
+    }
+
+    void Deliver(std::vector<TProto>& Batch) {
+        //older spilled events go first, so the server sees events in order
+        if (std::chrono::steady_clock::now() >= RetryAt && ReplaySpill()) {
+            const grpc::Status Status = SendBatch(Batch);
+            if (Status.ok()) {
+                Sent.fetch_add(Batch.size(), std::memory_order_relaxed);
+                return;
+            }
+            if (!IsUnreachable(Status)) {
+                Rejected.fetch_add(Batch.size(), std::memory_order_relaxed);
+                return;
+            }
+            RetryAt = std::chrono::steady_clock::now() + Config.RetryInterval;
+        }
+        Spill(Batch);
+    }
+
+    grpc::Status SendBatch(std::vector<TProto>& Batch) {
+        Batches.fetch_add(1, std::memory_order_relaxed);
+        return Send(Batch, std::chrono::system_clock::now() + Config.SendTimeout);
+    }
+
+    //records are a 4-byte little-endian length and the serialized event
+    void Spill(const std::vector<TProto>& Batch) {
+        if (Config.SpillPath.empty() || SpillBytes >= Config.MaxSpillBytes) {
+            Dropped.fetch_add(Batch.size(), std::memory_order_relaxed);
+            return;
+        }
+        std::ofstream Out(Config.SpillPath, std::ios::binary | std::ios::app);
+        std::string Bytes;
+        uint64_t Written = 0;
+        for (const TProto& Event : Batch) {
+            Event.SerializeToString(&Bytes);
+            const uint32_t Size = static_cast<uint32_t>(Bytes.size());
+            const char Prefix[4] = {static_cast<char>(Size), static_cast<char>(Size >> 8), static_cast<char>(Size >> 16), static_cast<char>(Size >> 24)};
+            Out.write(Prefix, sizeof(Prefix));
+            Out.write(Bytes.data(), static_cast<std::streamsize>(Bytes.size()));
+            Written += sizeof(Prefix) + Bytes.size();
+        }
+        Out.flush();
+        if (!Out) {
+            Dropped.fetch_add(Batch.size(), std::memory_order_relaxed);
+            return;
+        }
+        SpillBytes += Written;
+        Spilled.fetch_add(Batch.size(), std::memory_order_relaxed);
+    }
+
+    static bool ReadRecord(std::ifstream& In, std::string& Bytes) {
+        unsigned char Prefix[4];
+        if (!In.read(reinterpret_cast<char*>(Prefix), sizeof(Prefix))) return false;
+        const uint32_t Size = Prefix[0] | Prefix[1] << 8 | Prefix[2] << 16 | static_cast<uint32_t>(Prefix[3]) << 24;
+        Bytes.resize(Size);
+        //a record cut short by a crash ends the file
+        return static_cast<bool>(In.read(Bytes.data(), Size));
+    }
+
+    /** Sends the spill file a batch at a time. Returns true once it is empty. */
+    bool ReplaySpill() {
+        if (SpillBytes == 0) return true;
+        std::ifstream In(Config.SpillPath, std::ios::binary);
+        std::vector<TProto> Batch;
+        std::string Bytes;
+        for (;;) {
+            const std::streamoff BatchStart = In.tellg();
+            Batch.clear();
+            while (static_cast<int32_t>(Batch.size()) < Config.BatchSize && ReadRecord(In, Bytes)) {
+                if (!Batch.emplace_back().ParseFromString(Bytes)) {
+                    Batch.pop_back();
+                    Rejected.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+            if (Batch.empty()) break;
+            const grpc::Status Status = SendBatch(Batch);
+            if (Status.ok()) {
+                Sent.fetch_add(Batch.size(), std::memory_order_relaxed);
+                Replayed.fetch_add(Batch.size(), std::memory_order_relaxed);
+            } else if (IsUnreachable(Status)) {
+                RetryAt = std::chrono::steady_clock::now() + Config.RetryInterval;
+                KeepSpillFrom(In, BatchStart);
+                return false;
+            } else {
+                Rejected.fetch_add(Batch.size(), std::memory_order_relaxed);
+            }
+        }
+        In.close();
+        std::error_code Error;
+        std::filesystem::remove(Config.SpillPath, Error);
+        SpillBytes = 0;
+        return true;
+    }
+
+    //drops the replayed front of the spill file by copying what is left over it
+    void KeepSpillFrom(std::ifstream& In, std::streamoff Offset) {
+        In.clear();
+        In.seekg(Offset);
+        const std::string Temp = Config.SpillPath + ".tmp";
+        {
+            std::ofstream Out(Temp, std::ios::binary | std::ios::trunc);
+            Out << In.rdbuf();
+        }
+        In.close();
+        std::error_code Error;
+        std::filesystem::rename(Temp, Config.SpillPath, Error);
+        const uintmax_t Size = std::filesystem::file_size(Config.SpillPath, Error);
+        SpillBytes = Error ? 0 : static_cast<uint64_t>(Size);
+    }
+
+    const FSpoolConfig Config;
+    const FConvert Convert;
+    const FSend Send;
+    TBoundedQueue<TEvent> Queue;
+    std::atomic<int32_t> Pending{0};
+
+    std::mutex Mutex;
+    std::condition_variable Wake;
+    bool bStopping = false;
+    bool bFlushRequested = false;
+
+    //only touched by the sender thread
+    uint64_t SpillBytes = 0;
+    std::chrono::steady_clock::time_point RetryAt;
+
+    std::atomic<uint64_t> Sent{0};
+    std::atomic<uint64_t> Batches{0};
+    std::atomic<uint64_t> Spilled{0};
+    std::atomic<uint64_t> Replayed{0};
+    std::atomic<uint64_t> Dropped{0};
+    std::atomic<uint64_t> Rejected{0};
+
+    //started last, once everything it uses is constructed
+    std::thread Thread;
+};
+
+}
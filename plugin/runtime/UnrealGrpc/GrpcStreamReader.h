@@ -0,0 +1,343 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <grpcpp/grpcpp.h>
+#include "UnrealGrpc/GrpcCancellation.h"
+#include "UnrealGrpc/GrpcChannelPool.h"
+
+namespace UnrealGrpc {
+
+enum class EStreamOverflow : uint8_t {
+    /** Stop reading until the consumer drains the buffer. The server is slowed down by HTTP/2 flow control. */
+    Pause,
+    /** Keep reading and drop the oldest buffered message, for state streams where only recent messages matter. */
+    DropOldest,
+};
+
+struct FStreamBufferConfig {
+    /** Most converted messages held at once. Reaching it pauses reads or starts dropping. */
+    int32_t HighWatermark = 64;
+    /** A paused stream resumes reading once the consumer has drained the buffer down to this. */
+    int32_t LowWatermark = 16;
+    EStreamOverflow Overflow = EStreamOverflow::Pause;
+};
+
+/**
+ * Server stream read into a bounded buffer on gRPC's callback API. Messages are converted on gRPC's
+ * threads as they arrive and popped by the consumer, usually the game thread. When the consumer
+ * stalls, the buffer stops at HighWatermark instead of growing, so memory stays bounded through
+ * hitches such as level loads. Keeps itself alive until the stream is over.
+ *
+ * While paused no read is pending, so a hold keeps gRPC from finishing the call under the consumer;
+ * the stream ends only once the consumer resumes it or calls Cancel. Cancel a paused stream you no
+ * longer want, or it stays open.
+ */
+template <typename TProtoResponse, typename TResult>
+class TBufferedStreamReader final : public grpc::ClientReadReactor<TProtoResponse> {
+public:
+    using FConvert = TResult (*)(const TProtoResponse&);
+
+    /** Bind(Context, Reactor, ChannelIndex) attaches the reactor to the call through the stub's async() interface. */
+    template <typename TBind>
+    static std::shared_ptr<TBufferedStreamReader> Start(FChannelPool& Pool, const FStreamBufferConfig& Config, FConvert Convert,
+        const FCancellationToken& Cancellation, TBind&& Bind) {
+        std::shared_ptr<TBufferedStreamReader> Reader(new TBufferedStreamReader(Pool.Acquire(), Config, Convert));
+        Reader->Self = Reader;
+        Reader->Registration = Cancellation.Register(Reader->Context);
+        Bind(&Reader->Context, Reader.get(), Reader->Lease.GetIndex());
+        //holds can only be added from a reaction after this, so the first pause is covered up front
+        Reader->AddHold();
+        Reader->bHeld = true;
+        Reader->StartRead(&Reader->ReadBuffer);
+        Reader->StartCall();
+        return Reader;
+    }
+
+    /** Moves the oldest buffered message to Out. Returns false when the buffer is empty. */
+    bool Pop(TResult& Out) {
+        bool bResume = false;
+        {
+            std::lock_guard Lock(Mutex);
+            if (Buffer.empty()) return false;
+            Out = std::move(Buffer.front());
+            Buffer.pop_front();
+            bResume = ShouldResume();
+        }
+        if (bResume) Resume();
+        return true;
+    }
+
+    /** Moves up to MaxCount buffered messages to the end of Out, oldest first. Returns how many were moved. */
+    int32_t Drain(std::vector<TResult>& Out, int32_t MaxCount = INT32_MAX) {
+        int32_t Count = 0;
+        bool bResume = false;
+        {
+            std::lock_guard Lock(Mutex);
+            while (!Buffer.empty() && Count < MaxCount) {
+                Out.push_back(std::move(Buffer.front()));
+                Buffer.pop_front();
+                Count++;
+            }
+            bResume = ShouldResume();
+        }
+        if (bResume) Resume();
+        return Count;
+    }
+
+    [[nodiscard]] int32_t Num() const {
+        std::lock_guard Lock(Mutex);
+        return static_cast<int32_t>(Buffer.size());
+    }
+
+    /** Messages thrown away by the DropOldest policy. */
+    [[nodiscard]] uint64_t GetDropped() const {
+        std::lock_guard Lock(Mutex);
+        return Dropped;
+    }
+
+    /** True once the stream has ended; buffered messages can still be popped. */
+    [[nodiscard]] bool IsDone() const {
+        std::lock_guard Lock(Mutex);
+        return bDone;
+    }
+
+    /** Final status, valid once IsDone. */
+    [[nodiscard]] grpc::Status GetStatus() const {
+        std::lock_guard Lock(Mutex);
+        return Status;
+    }
+
+    void Cancel() {
+        Context.TryCancel();
+        bool bResume = false;
+        {
+            std::lock_guard Lock(Mutex);
+            //a paused stream has no read to fail, so read once more to let the call finish
+            bResume = bPaused && !bDone;
+            if (bResume) bPaused = bHeld = false;
+        }
+        if (bResume) Resume();
+    }
+
+    void OnReadDone(bool bOk) override {
+        if (!bOk) {
+            bool bRelease = false;
+            {
+                std::lock_guard Lock(Mutex);
+                bRelease = bHeld;
+                bHeld = false;
+            }
+            //nothing left to read, so let OnDone run
+            if (bRelease) this->RemoveHold();
+            return;
+        }
+        //convert outside the lock so the consumer never waits on it
+        TResult Converted = Convert(ReadBuffer);
+        bool bContinue = true;
+        {
+            std::lock_guard Lock(Mutex);
+            Buffer.push_back(std::move(Converted));
+            if (static_cast<int32_t>(Buffer.size()) > Config.HighWatermark && Config.Overflow == EStreamOverflow::DropOldest) {
+                Buffer.pop_front();
+                Dropped++;
+            }
+            if (Config.Overflow == EStreamOverflow::Pause && static_cast<int32_t>(Buffer.size()) >= Config.HighWatermark) {
+                bPaused = true;
+                bContinue = false;
+                //added inside a reaction, where gRPC allows it
+                if (!bHeld) this->AddHold();
+                bHeld = true;
+            }
+        }
+        if (bContinue) this->StartRead(&ReadBuffer);
+    }
+
+    void OnDone(const grpc::Status& InStatus) override {
+        Lease.Release();
+        Registration.Reset();
+        {
+            std::lock_guard Lock(Mutex);
+            Status = InStatus;
+            bDone = true;
+        }
+        //may destroy this reader if the consumer already let go of it
+        Self.reset();
+    }
+
+private:
+    TBufferedStreamReader(FChannelPool::FLease&& InLease, const FStreamBufferConfig& InConfig, FConvert InConvert)
+        : Config(Sanitize(InConfig)), Convert(InConvert), Lease(std::move(InLease)) {}
+
+    static FStreamBufferConfig Sanitize(FStreamBufferConfig Config) {
+        Config.HighWatermark = std::max(Config.HighWatermark, 1);
+        Config.LowWatermark = std::clamp(Config.LowWatermark, 0, Config.HighWatermark - 1);
+        return Config;
+    }
+
+    //called with the lock held; clears the pause so exactly one caller issues the next read. A paused
+    //stream always has a hold, which that caller now owns
+    bool ShouldResume() {
+        if (bDone || !bPaused || static_cast<int32_t>(Buffer.size()) > Config.LowWatermark) return false;
+        bPaused = bHeld = false;
+        return true;
+    }
+
+    //called without the lock by whoever cleared the pause. The read is pending before the hold goes,
+    //so the call can't finish in between, and a pause in between takes a hold of its own
+    void Resume() {
+        this->StartRead(&ReadBuffer);
+        this->RemoveHold();
+    }
+
+    const FStreamBufferConfig Config;
+    const FConvert Convert;
+    FChannelPool::FLease Lease;
+    grpc::ClientContext Context;
+    FCancellationToken::FRegistration Registration;
+    TProtoResponse ReadBuffer;
+    std::shared_ptr<TBufferedStreamReader> Self;
+
+    mutable std::mutex Mutex;
+    std::deque<TResult> Buffer;
+    uint64_t Dropped = 0;
+    grpc::Status Status;
+    bool bPaused = false;
+    //a hold is outstanding, taken in Start and again on each pause
+    bool bHeld = false;
+    bool bDone = false;
+};
+
+/**
+ * Server stream that keeps only the newest message for each key, for state-sync streams such as
+ * positions or scores. Messages stay as raw protos until the consumer takes them, so an update
+ * that is superseded before the next Consume is never converted. Reads never pause: memory is
+ * bounded by the number of distinct keys. Keeps itself alive until the stream is over.
+ */
+template <typename TProtoResponse, typename TResult, typename TKey>
+class TLatestValueStreamReader final : public grpc::ClientReadReactor<TProtoResponse> {
+public:
+    using FConvert = TResult (*)(const TProtoResponse&);
+    using FGetKey = TKey (*)(const TProtoResponse&);
+
+    /** Bind(Context, Reactor, ChannelIndex) attaches the reactor to the call through the stub's async() interface. */
+    template <typename TBind>
+    static std::shared_ptr<TLatestValueStreamReader> Start(FChannelPool& Pool, FConvert Convert, FGetKey GetKey,
+        const FCancellationToken& Cancellation, TBind&& Bind) {
+        std::shared_ptr<TLatestValueStreamReader> Reader(new TLatestValueStreamReader(Pool.Acquire(), Convert, GetKey));
+        Reader->Self = Reader;
+        Reader->Registration = Cancellation.Register(Reader->Context);
+        Bind(&Reader->Context, Reader.get(), Reader->Lease.GetIndex());
+        Reader->StartRead(&Reader->ReadBuffer);
+        Reader->StartCall();
+        return Reader;
+    }
+
+    /**
+     * Converts the newest message of every key that changed since the last call and appends them
+     * to Out. Returns how many were appended. Call from a single consumer thread.
+     */
+    int32_t Consume(std::vector<TResult>& Out) {
+        {
+            std::lock_guard Lock(Mutex);
+            //the consumer's map was cleared last time, so swapping hands its buckets back to the reader
+            std::swap(Pending, Taken);
+        }
+        for (const auto& [Key, Message] : Taken) Out.push_back(Convert(Message));
+        const int32_t Count = static_cast<int32_t>(Taken.size());
+        Taken.clear();
+        return Count;
+    }
+
+    /** Converts the newest message for Key if it changed since it was last consumed. */
+    bool Consume(const TKey& Key, TResult& Out) {
+        TProtoResponse Message;
+        {
+            std::lock_guard Lock(Mutex);
+            auto It = Pending.find(Key);
+            if (It == Pending.end()) return false;
+            Message.Swap(&It->second);
+            Pending.erase(It);
+        }
+        Out = Convert(Message);
+        return true;
+    }
+
+    /** Keys with an update waiting to be consumed. */
+    [[nodiscard]] int32_t Num() const {
+        std::lock_guard Lock(Mutex);
+        return static_cast<int32_t>(Pending.size());
+    }
+
+    /** Messages replaced by a newer one for the same key before they were consumed, i.e. conversions saved. */
+    [[nodiscard]] uint64_t GetSuperseded() const {
+        std::lock_guard Lock(Mutex);
+        return Superseded;
+    }
+
+    /** True once the stream has ended; pending updates can still be consumed. */
+    [[nodiscard]] bool IsDone() const {
+        std::lock_guard Lock(Mutex);
+        return bDone;
+    }
+
+    /** Final status, valid once IsDone. */
+    [[nodiscard]] grpc::Status GetStatus() const {
+        std::lock_guard Lock(Mutex);
+        return Status;
+    }
+
+    void Cancel() { Context.TryCancel(); }
+
+    void OnReadDone(bool bOk) override {
+        if (!bOk) return;
+        TKey Key = GetKey(ReadBuffer);
+        {
+            std::lock_guard Lock(Mutex);
+            auto [It, bInserted] = Pending.try_emplace(std::move(Key));
+            if (!bInserted) Superseded++;
+            //the superseded message comes back as the read buffer, so its allocations are reused
+            It->second.Swap(&ReadBuffer);
+        }
+        this->StartRead(&ReadBuffer);
+    }
+
+    void OnDone(const grpc::Status& InStatus) override {
+        Lease.Release();
+        Registration.Reset();
+        {
+            std::lock_guard Lock(Mutex);
+            Status = InStatus;
+            bDone = true;
+        }
+        //may destroy this reader if the consumer already let go of it
+        Self.reset();
+    }
+
+private:
+    TLatestValueStreamReader(FChannelPool::FLease&& InLease, FConvert InConvert, FGetKey InGetKey)
+        : Convert(InConvert), GetKey(InGetKey), Lease(std::move(InLease)) {}
+
+    const FConvert Convert;
+    const FGetKey GetKey;
+    FChannelPool::FLease Lease;
+    grpc::ClientContext Context;
+    FCancellationToken::FRegistration Registration;
+    TProtoResponse ReadBuffer;
+    std::shared_ptr<TLatestValueStreamReader> Self;
+    //only touched by the consumer
+    std::unordered_map<TKey, TProtoResponse> Taken;
+
+    mutable std::mutex Mutex;
+    std::unordered_map<TKey, TProtoResponse> Pending;
+    uint64_t Superseded = 0;
+    grpc::Status Status;
+    bool bDone = false;
+};
+
+}
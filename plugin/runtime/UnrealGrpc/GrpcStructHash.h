@@ -0,0 +1,134 @@
+#pragma once
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+
+namespace UnrealGrpc {
+
+/*
+ * Building blocks for the GetTypeHash the plugin generates for every message struct. Hashes are
+ * 64-bit until FinalizeHash folds them into the uint32 TSet and TMap expect. Strings hash their
+ * characters exactly, matching the case-sensitive operator== generated alongside.
+ */
+
+inline constexpr uint64_t HashMultiplier = 0x9E3779B97F4A7C15ull;
+
+/** Bits of a number, bool or enum. -0.0 hashes like 0.0, since the two compare equal. */
+template <typename T>
+uint64_t HashBits(T Value) {
+    if constexpr (std::is_same_v<T, float>) {
+        return std::bit_cast<uint32_t>(Value + 0.0f);
+    } else if constexpr (std::is_same_v<T, double>) {
+        return std::bit_cast<uint64_t>(Value + 0.0);
+    } else {
+        return static_cast<uint64_t>(Value);
+    }
+}
+
+inline uint64_t HashMix(uint64_t Hash, uint64_t Value) {
+    return (std::rotl(Hash, 23) ^ Value) * HashMultiplier;
+}
+
+/** Scrambles one value, offset by its position so swapped values hash apart. */
+inline uint64_t HashLane(uint64_t Value, size_t Index) {
+    uint64_t Lane = (Value + (Index + 1) * HashMultiplier) * 0xC2B2AE3D27D4EB4Full;
+    Lane ^= Lane >> 31;
+    return Lane * 0x165667B19E3779F9ull;
+}
+
+template <size_t... Index, typename... T>
+uint64_t HashScalars(std::index_sequence<Index...>, const T&... Values) {
+    //no lane depends on another, so the multiplies and shifts can run side by side in vector registers
+    return (uint64_t{0} + ... + HashLane(HashBits(Values), Index));
+}
+
+/** Hashes the scalar fields of a struct in one expression. */
+template <typename... T>
+uint64_t HashScalars(const T&... Values) {
+    return HashScalars(std::index_sequence_for<T...>(), Values...);
+}
+
+/** Hashes memory 32 bytes at a time, in four independent lanes. */
+inline uint64_t HashBytes(const void* Data, size_t Size) {
+    const uint8_t* Bytes = static_cast<const uint8_t*>(Data);
+    uint64_t Lanes[4] = {Size, HashMultiplier, 0xC2B2AE3D27D4EB4Full, 0x165667B19E3779F9ull};
+    const auto Round = [&Lanes](const uint8_t* Block) {
+        for (int i = 0; i < 4; i++) {
+            uint64_t Word;
+            std::memcpy(&Word, Block + i * 8, sizeof(Word));
+            Lanes[i] = std::rotl((Lanes[i] ^ Word) * HashMultiplier, 29);
+        }
+    };
+    size_t Offset = 0;
+    for (; Offset + 32 <= Size; Offset += 32) Round(Bytes + Offset);
+    if (Offset < Size) {
+        //the size seeded the first lane, so zero padding can't collide with real zeros
+        uint8_t Tail[32] = {};
+        std::memcpy(Tail, Bytes + Offset, Size - Offset);
+        Round(Tail);
+    }
+    return HashMix(HashMix(HashMix(Lanes[0], Lanes[1]), Lanes[2]), Lanes[3]);
+}
+
+/** Hashes an array of numbers, bools or enums. Integers hash as memory; floats go one by one so -0.0 matches 0.0. */
+template <typename T>
+uint64_t HashArray(const T* Data, int32_t Num) {
+    if constexpr (std::is_integral_v<T> || std::is_enum_v<T>) {
+        return HashBytes(Data, static_cast<size_t>(Num) * sizeof(T));
+    } else {
+        uint64_t Hash = static_cast<uint64_t>(Num);
+        for (int32_t i = 0; i < Num; i++) Hash = HashMix(Hash, HashBits(Data[i]));
+        return Hash;
+    }
+}
+
+/** Hashes each element of an array with HashElement, in order. */
+template <typename TArrayType, typename FHashElement>
+uint64_t HashEach(const TArrayType& Array, FHashElement HashElement) {
+    uint64_t Hash = static_cast<uint64_t>(Array.Num());
+    for (const auto& Element : Array) Hash = HashMix(Hash, HashElement(Element));
+    return Hash;
+}
+
+/** Hashes a map regardless of its order, so two maps holding the same pairs hash the same. */
+template <typename TMapType, typename FHashKey, typename FHashValue>
+uint64_t HashMap(const TMapType& Map, FHashKey HashKey, FHashValue HashValue) {
+    uint64_t Sum = 0;
+    for (const auto& Pair : Map) Sum += HashMix(HashKey(Pair.Key), HashValue(Pair.Value));
+    return HashMix(static_cast<uint64_t>(Map.Num()), Sum);
+}
+
+template <typename TArrayType, typename FEqual>
+bool ArraysEqual(const TArrayType& A, const TArrayType& B, FEqual Equal) {
+    if (A.Num() != B.Num()) return false;
+    for (int32_t i = 0; i < A.Num(); i++) {
+        if (!Equal(A[i], B[i])) return false;
+    }
+    return true;
+}
+
+/** Compares maps regardless of their order. Keys are looked up the way the map finds them. */
+template <typename TMapType, typename FEqual>
+bool MapsEqual(const TMapType& A, const TMapType& B, FEqual Equal) {
+    if (A.Num() != B.Num()) return false;
+    for (const auto& Pair : A) {
+        const auto* Found = B.Find(Pair.Key);
+        if (!Found || !Equal(Pair.Value, *Found)) return false;
+    }
+    return true;
+}
+
+/** Folds a 64-bit hash into the uint32 GetTypeHash returns, mixing every bit into the result. */
+inline uint32_t FinalizeHash(uint64_t Hash) {
+    Hash ^= Hash >> 33;
+    Hash *= 0xFF51AFD7ED558CCDull;
+    Hash ^= Hash >> 33;
+    Hash *= 0xC4CEB9FE1A85EC53ull;
+    Hash ^= Hash >> 33;
+    return static_cast<uint32_t>(Hash);
+}
+
+}
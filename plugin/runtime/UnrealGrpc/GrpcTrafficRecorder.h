@@ -0,0 +1,266 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/io/zero_copy_stream_impl.h>
+#include <grpcpp/grpcpp.h>
+#include <grpcpp/support/client_interceptor.h>
+#include "UnrealGrpc/GrpcSerialization.h"
+
+namespace UnrealGrpc {
+
+/*
+ * Recording file layout. Integers are varints, byte strings are a varint length and the bytes.
+ *
+ *   header:  "UGRPCREC", version (1), wall-clock start in microseconds since the Unix epoch
+ *   method:  1, method id, method path
+ *   call:    2, method id, start and duration in microseconds from the start of the recording,
+ *            status code, request bytes, response bytes
+ *
+ * A method record comes before the first call that uses its id. Calls are written as they
+ * complete, so their start times are only roughly in order.
+ */
+inline constexpr char RecordingMagic[8] = {'U', 'G', 'R', 'P', 'C', 'R', 'E', 'C'};
+inline constexpr uint32_t RecordingVersion = 1;
+
+/** One unary call read back from a recording. Request and Response are the serialized messages. */
+struct FRecordedCall {
+    std::string Method;
+    std::chrono::microseconds Start{0};
+    std::chrono::microseconds Duration{0};
+    grpc::StatusCode Status = grpc::StatusCode::OK;
+    std::string Request;
+    std::string Response;
+};
+
+/**
+ * Process-wide sink for the calls that FRecordingInterceptor sees. Idle until Start, so the
+ * interceptor costs one atomic load per call the rest of the time. Calls are encoded on the
+ * thread that completes them and written out in large blocks.
+ */
+class FTrafficRecorder {
+public:
+    static FTrafficRecorder& Get() {
+        static FTrafficRecorder Instance;
+        return Instance;
+    }
+
+    /** Starts a new recording at Path, replacing any in progress. Recording stops by itself once the file reaches MaxBytes. */
+    bool Start(const std::string& Path, uint64_t MaxBytes = 256ull << 20) {
+        std::lock_guard Lock(Mutex);
+        CloseLocked();
+        File.open(Path, std::ios::binary | std::ios::trunc);
+        if (!File) return false;
+        Epoch = std::chrono::steady_clock::now();
+        const auto WallUs = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+        Pending.assign(RecordingMagic, sizeof(RecordingMagic));
+        AppendVarint(Pending, RecordingVersion);
+        AppendVarint(Pending, static_cast<uint64_t>(WallUs));
+        MethodIds.clear();
+        Limit = MaxBytes;
+        Written = 0;
+        bRecording.store(true, std::memory_order_release);
+        return true;
+    }
+
+    /** Writes out what is buffered and closes the file. */
+    void Stop() {
+        std::lock_guard Lock(Mutex);
+        CloseLocked();
+    }
+
+    [[nodiscard]] bool IsRecording() const { return bRecording.load(std::memory_order_acquire); }
+    [[nodiscard]] uint64_t GetRecordedCalls() const { return Recorded.load(std::memory_order_relaxed); }
+
+    void Record(std::string_view Method, std::chrono::steady_clock::time_point Start, std::chrono::steady_clock::duration Duration,
+        grpc::StatusCode Status, std::string_view Request, std::string_view Response) {
+        //encoded outside the lock, which then only covers the copy into the block
+        thread_local std::string Encoded;
+        Encoded.clear();
+        AppendVarint(Encoded, std::chrono::duration_cast<std::chrono::microseconds>(Duration).count());
+        AppendVarint(Encoded, static_cast<uint64_t>(Status));
+        AppendBytes(Encoded, Request);
+        AppendBytes(Encoded, Response);
+
+        std::lock_guard Lock(Mutex);
+        if (!bRecording.load(std::memory_order_relaxed)) return;
+        auto It = MethodIds.find(Method);
+        if (It == MethodIds.end()) {
+            It = MethodIds.emplace(std::string(Method), MethodIds.size()).first;
+            AppendVarint(Pending, 1);
+            AppendVarint(Pending, It->second);
+            AppendBytes(Pending, Method);
+        }
+        //a call that started before Start counts as starting with the recording
+        const auto StartUs = std::max<int64_t>(std::chrono::duration_cast<std::chrono::microseconds>(Start - Epoch).count(), 0);
+        AppendVarint(Pending, 2);
+        AppendVarint(Pending, It->second);
+        AppendVarint(Pending, static_cast<uint64_t>(StartUs));
+        Pending += Encoded;
+        Recorded.fetch_add(1, std::memory_order_relaxed);
+        if (Pending.size() >= BlockBytes) WriteLocked();
+        if (Written >= Limit) CloseLocked();
+    }
+
+    static void AppendVarint(std::string& Out, uint64_t Value) {
+        uint8_t Bytes[10];
+        const uint8_t* End = google::protobuf::io::CodedOutputStream::WriteVarint64ToArray(Value, Bytes);
+        Out.append(reinterpret_cast<const char*>(Bytes), static_cast<size_t>(End - Bytes));
+    }
+
+    static void AppendBytes(std::string& Out, std::string_view Bytes) {
+        AppendVarint(Out, Bytes.size());
+        Out.append(Bytes.data(), Bytes.size());
+    }
+
+private:
+    static constexpr size_t BlockBytes = 256 * 1024;
+
+    FTrafficRecorder() = default;
+
+    ~FTrafficRecorder() {
+        std::lock_guard Lock(Mutex);
+        CloseLocked();
+    }
+
+    void WriteLocked() {
+        File.write(Pending.data(), static_cast<std::streamsize>(Pending.size()));
+        Written += Pending.size();
+        Pending.clear();
+    }
+
+    void CloseLocked() {
+        if (!File.is_open()) return;
+        bRecording.store(false, std::memory_order_release);
+        WriteLocked();
+        File.close();
+    }
+
+    std::atomic<bool> bRecording{false};
+    std::atomic<uint64_t> Recorded{0};
+    std::mutex Mutex;
+    std::ofstream File;
+    std::string Pending;
+    std::map<std::string, uint64_t, std::less<>> MethodIds;
+    std::chrono::steady_clock::time_point Epoch;
+    uint64_t Limit = 0;
+    uint64_t Written = 0;
+};
+
+/**
+ * Copies the request and response bytes of a unary call into FTrafficRecorder when it finishes.
+ * The request costs a copy of the buffer gRPC sends; the response is serialized again from the
+ * received message, which is protobuf unless the call was created inside an FScopedRecvCodec.
+ */
+class FRecordingInterceptor final : public grpc::experimental::Interceptor {
+public:
+    FRecordingInterceptor(FTrafficRecorder& InRecorder, std::string InMethod, const FRecvCodec* InCodec)
+        : Recorder(InRecorder), Method(std::move(InMethod)), Codec(InCodec) {}
+
+    void Intercept(grpc::experimental::InterceptorBatchMethods* Methods) override {
+        using grpc::experimental::InterceptionHookPoints;
+        if (Methods->QueryInterceptionHookPoint(InterceptionHookPoints::PRE_SEND_INITIAL_METADATA)) {
+            Start = std::chrono::steady_clock::now();
+        }
+        if (Methods->QueryInterceptionHookPoint(InterceptionHookPoints::PRE_SEND_MESSAGE)) {
+            if (const grpc::ByteBuffer* Buffer = Methods->GetSerializedSendMessage()) {
+                std::vector<grpc::Slice> Slices;
+                (void)Buffer->Dump(&Slices);
+                for (const grpc::Slice& Slice : Slices) Request.append(reinterpret_cast<const char*>(Slice.begin()), Slice.size());
+            }
+        }
+        if (Methods->QueryInterceptionHookPoint(InterceptionHookPoints::POST_RECV_MESSAGE)) {
+            if (const void* Message = Methods->GetRecvMessage()) SerializeRecv(Codec, Message, Response);
+        }
+        if (Methods->QueryInterceptionHookPoint(InterceptionHookPoints::POST_RECV_STATUS)) {
+            Recorder.Record(Method, Start, std::chrono::steady_clock::now() - Start, Methods->GetRecvStatus()->error_code(), Request, Response);
+        }
+        Methods->Proceed();
+    }
+
+private:
+    FTrafficRecorder& Recorder;
+    const std::string Method;
+    const FRecvCodec* Codec;
+    std::chrono::steady_clock::time_point Start;
+    std::string Request;
+    std::string Response;
+};
+
+/** Installed by the generated CreatePool of services with the record option. Streams aren't recorded. */
+class FRecordingInterceptorFactory final : public grpc::experimental::ClientInterceptorFactoryInterface {
+public:
+    grpc::experimental::Interceptor* CreateClientInterceptor(grpc::experimental::ClientRpcInfo* Info) override {
+        FTrafficRecorder& Recorder = FTrafficRecorder::Get();
+        if (!Recorder.IsRecording() || Info->type() != grpc::experimental::ClientRpcInfo::Type::UNARY) return nullptr;
+        return new FRecordingInterceptor(Recorder, Info->method(), FScopedRecvCodec::Get());
+    }
+};
+
+/**
+ * Reads a recording back, sorted by start time. Returns false if the file can't be read or isn't a
+ * recording; a record cut short, e.g. by a crash, ends the recording without failing it.
+ */
+inline bool LoadRecording(const std::string& Path, std::vector<FRecordedCall>& OutCalls, std::chrono::system_clock::time_point* OutWallStart = nullptr) {
+    std::ifstream In(Path, std::ios::binary);
+    char Magic[sizeof(RecordingMagic)];
+    if (!In.read(Magic, sizeof(Magic)) || std::memcmp(Magic, RecordingMagic, sizeof(Magic)) != 0) return false;
+    google::protobuf::io::IstreamInputStream Stream(&In);
+    //a fresh CodedInputStream per record keeps its 2 GB total limit from applying to the whole file
+    const auto ReadRecord = [&Stream](auto&& Read) {
+        google::protobuf::io::CodedInputStream Coded(&Stream);
+        return Read(Coded);
+    };
+    uint64_t Version = 0;
+    uint64_t WallUs = 0;
+    if (!ReadRecord([&](auto& Coded) { return Coded.ReadVarint64(&Version) && Coded.ReadVarint64(&WallUs); }) || Version != RecordingVersion) return false;
+    if (OutWallStart) *OutWallStart = std::chrono::system_clock::time_point(std::chrono::microseconds(WallUs));
+
+    std::vector<std::string> Methods;
+    OutCalls.clear();
+    const auto ReadBytes = [](google::protobuf::io::CodedInputStream& Coded, std::string& Out) {
+        uint32_t Size = 0;
+        return Coded.ReadVarint32(&Size) && Coded.ReadString(&Out, static_cast<int>(Size));
+    };
+    for (bool bMore = true; bMore;) {
+        bMore = ReadRecord([&](google::protobuf::io::CodedInputStream& Coded) {
+            uint64_t Kind = 0;
+            uint64_t Id = 0;
+            if (!Coded.ReadVarint64(&Kind) || !Coded.ReadVarint64(&Id)) return false;
+            if (Kind == 1) {
+                std::string Method;
+                if (!ReadBytes(Coded, Method)) return false;
+                if (Methods.size() <= Id) Methods.resize(Id + 1);
+                Methods[Id] = std::move(Method);
+                return true;
+            }
+            FRecordedCall Call;
+            uint64_t StartUs = 0;
+            uint64_t DurationUs = 0;
+            uint64_t Status = 0;
+            if (Kind != 2 || Id >= Methods.size() || !Coded.ReadVarint64(&StartUs) || !Coded.ReadVarint64(&DurationUs) || !Coded.ReadVarint64(&Status) ||
+                !ReadBytes(Coded, Call.Request) || !ReadBytes(Coded, Call.Response)) {
+                return false;
+            }
+            Call.Method = Methods[Id];
+            Call.Start = std::chrono::microseconds(StartUs);
+            Call.Duration = std::chrono::microseconds(DurationUs);
+            Call.Status = static_cast<grpc::StatusCode>(Status);
+            OutCalls.push_back(std::move(Call));
+            return true;
+        });
+    }
+    std::stable_sort(OutCalls.begin(), OutCalls.end(), [](const FRecordedCall& A, const FRecordedCall& B) { return A.Start < B.Start; });
+    return true;
+}
+
+}
@@ -0,0 +1,436 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+#include <grpcpp/grpcpp.h>
+#include "UnrealGrpc/GrpcSerialization.h"
+
+namespace UnrealGrpc {
+
+/**
+ * Reads and writes a USTRUCT in protobuf wire format without a protobuf message in between.
+ * Specialized for each message by the generated <File>Serialization.h with:
+ *   static size_t Size(const T& In, FWireSizes& Sizes);
+ *   static uint8_t* Write(const T& In, FWireSizes& Sizes, uint8_t* Out);
+ *   static bool Read(FWireReader& Reader, T& Out);
+ * Read merges into Out and returns whether the whole message was well formed.
+ */
+template <typename T>
+struct TWireCodec;
+
+/**
+ * Lengths of the length-delimited parts of a message, recorded by Size in the order Write
+ * reaches them. Protobuf caches these in the message; a USTRUCT has nowhere to keep them.
+ */
+class FWireSizes {
+public:
+    void Reset() {
+        Sizes.clear();
+        Cursor = 0;
+    }
+
+    /** Holds a place for a length that is only known after its contents have been sized. */
+    size_t Reserve() {
+        Sizes.push_back(0);
+        return Sizes.size() - 1;
+    }
+
+    /** Fills a reserved length and returns what it costs on the wire, prefix included. */
+    size_t Set(size_t Slot, size_t Length);
+
+    size_t Add(size_t Length) { return Set(Reserve(), Length); }
+
+    /** The next recorded length, for Write. */
+    uint32_t Next() { return Sizes[Cursor++]; }
+
+private:
+    std::vector<uint32_t> Sizes;
+    size_t Cursor = 0;
+};
+
+namespace Wire {
+
+enum EWireType : uint32_t {
+    Varint = 0,
+    Fixed64 = 1,
+    LengthDelimited = 2,
+    Fixed32 = 5,
+};
+
+inline size_t VarintSize(uint64_t Value) {
+    size_t Size = 1;
+    while (Value >= 0x80) {
+        Value >>= 7;
+        Size++;
+    }
+    return Size;
+}
+
+inline uint8_t* WriteVarint(uint64_t Value, uint8_t* Out) {
+    while (Value >= 0x80) {
+        *Out++ = static_cast<uint8_t>(Value | 0x80);
+        Value >>= 7;
+    }
+    *Out++ = static_cast<uint8_t>(Value);
+    return Out;
+}
+
+inline uint8_t* WriteFixed32(uint32_t Value, uint8_t* Out) {
+    for (int32_t i = 0; i < 4; i++) *Out++ = static_cast<uint8_t>(Value >> (8 * i));
+    return Out;
+}
+
+inline uint8_t* WriteFixed64(uint64_t Value, uint8_t* Out) {
+    for (int32_t i = 0; i < 8; i++) *Out++ = static_cast<uint8_t>(Value >> (8 * i));
+    return Out;
+}
+
+//the scalar types generated structs use, each with the encoding protoc gives it. Dispatched on
+//traits rather than overloaded, because int64 isn't the same type as int64_t on every platform
+template <typename TValue>
+size_t ValueSize(TValue Value) {
+    if constexpr (std::is_same_v<TValue, double>) return 8;
+    else if constexpr (std::is_same_v<TValue, float>) return 4;
+    else if constexpr (std::is_same_v<TValue, bool>) return 1;
+    else if constexpr (std::is_enum_v<TValue>) return ValueSize(static_cast<int32_t>(Value));
+    //negative int32s are sign-extended to ten bytes, as protobuf does
+    else if constexpr (std::is_signed_v<TValue>) return VarintSize(static_cast<uint64_t>(static_cast<int64_t>(Value)));
+    else return VarintSize(static_cast<uint64_t>(Value));
+}
+
+template <typename TValue>
+uint8_t* WriteValue(TValue Value, uint8_t* Out) {
+    if constexpr (std::is_same_v<TValue, double>) {
+        uint64_t Bits;
+        std::memcpy(&Bits, &Value, sizeof(Bits));
+        return WriteFixed64(Bits, Out);
+    } else if constexpr (std::is_same_v<TValue, float>) {
+        uint32_t Bits;
+        std::memcpy(&Bits, &Value, sizeof(Bits));
+        return WriteFixed32(Bits, Out);
+    } else if constexpr (std::is_same_v<TValue, bool>) {
+        return WriteVarint(Value ? 1 : 0, Out);
+    } else if constexpr (std::is_enum_v<TValue>) {
+        return WriteValue(static_cast<int32_t>(Value), Out);
+    } else if constexpr (std::is_signed_v<TValue>) {
+        return WriteVarint(static_cast<uint64_t>(static_cast<int64_t>(Value)), Out);
+    } else {
+        return WriteVarint(static_cast<uint64_t>(Value), Out);
+    }
+}
+
+template <typename TValue>
+constexpr EWireType GetWireType() {
+    if constexpr (std::is_same_v<TValue, double>) return Fixed64;
+    else if constexpr (std::is_same_v<TValue, float>) return Fixed32;
+    else return Varint;
+}
+
+/** Whether proto3 leaves Value off the wire. Floats compare by bits, so -0.0 is still written. */
+template <typename TValue>
+bool IsDefault(TValue Value) {
+    if constexpr (std::is_floating_point_v<TValue>) {
+        TValue Zero = 0;
+        return std::memcmp(&Value, &Zero, sizeof(TValue)) == 0;
+    } else {
+        return Value == TValue{};
+    }
+}
+
+/** UTF-8 length of a UTF-16 or UTF-32 string (or one that is already UTF-8), without converting it. */
+template <typename TChar>
+size_t Utf8Size(const TChar* Str, size_t Len) {
+    if constexpr (sizeof(TChar) == 1) {
+        return Len;
+    } else {
+        size_t Size = 0;
+        for (size_t i = 0; i < Len; i++) {
+            const uint32_t Char = static_cast<uint32_t>(Str[i]);
+            if (Char < 0x80) Size += 1;
+            else if (Char < 0x800) Size += 2;
+            else if (sizeof(TChar) == 2 && Char >= 0xD800 && Char < 0xDC00 && i + 1 < Len) {
+                //a surrogate pair is one four-byte code point
+                Size += 4;
+                i++;
+            } else if (Char < 0x10000) Size += 3;
+            else Size += 4;
+        }
+        return Size;
+    }
+}
+
+template <typename TChar>
+uint8_t* WriteUtf8(const TChar* Str, size_t Len, uint8_t* Out) {
+    if constexpr (sizeof(TChar) == 1) {
+        if (Len) std::memcpy(Out, Str, Len);
+        return Out + Len;
+    } else {
+        for (size_t i = 0; i < Len; i++) {
+            uint32_t Char = static_cast<uint32_t>(Str[i]);
+            if (sizeof(TChar) == 2 && Char >= 0xD800 && Char < 0xDC00 && i + 1 < Len) {
+                Char = 0x10000 + ((Char - 0xD800) << 10) + (static_cast<uint32_t>(Str[++i]) - 0xDC00);
+            }
+            if (Char < 0x80) {
+                *Out++ = static_cast<uint8_t>(Char);
+            } else if (Char < 0x800) {
+                *Out++ = static_cast<uint8_t>(0xC0 | (Char >> 6));
+                *Out++ = static_cast<uint8_t>(0x80 | (Char & 0x3F));
+            } else if (Char < 0x10000) {
+                *Out++ = static_cast<uint8_t>(0xE0 | (Char >> 12));
+                *Out++ = static_cast<uint8_t>(0x80 | ((Char >> 6) & 0x3F));
+                *Out++ = static_cast<uint8_t>(0x80 | (Char & 0x3F));
+            } else {
+                *Out++ = static_cast<uint8_t>(0xF0 | (Char >> 18));
+                *Out++ = static_cast<uint8_t>(0x80 | ((Char >> 12) & 0x3F));
+                *Out++ = static_cast<uint8_t>(0x80 | ((Char >> 6) & 0x3F));
+                *Out++ = static_cast<uint8_t>(0x80 | (Char & 0x3F));
+            }
+        }
+        return Out;
+    }
+}
+
+template <typename TValue>
+size_t ScalarSize(size_t TagSize, TValue Value) { return TagSize + ValueSize(Value); }
+
+template <typename TValue>
+uint8_t* WriteScalar(uint32_t Tag, TValue Value, uint8_t* Out) { return WriteValue(Value, WriteVarint(Tag, Out)); }
+
+template <typename TChar>
+size_t StringSize(size_t TagSize, const TChar* Str, size_t Len, FWireSizes& Sizes) { return TagSize + Sizes.Add(Utf8Size(Str, Len)); }
+
+template <typename TChar>
+uint8_t* WriteString(uint32_t Tag, const TChar* Str, size_t Len, FWireSizes& Sizes, uint8_t* Out) {
+    Out = WriteVarint(Sizes.Next(), WriteVarint(Tag, Out));
+    return WriteUtf8(Str, Len, Out);
+}
+
+template <typename TMessage>
+size_t MessageSize(size_t TagSize, const TMessage& Message, FWireSizes& Sizes) {
+    const size_t Slot = Sizes.Reserve();
+    return TagSize + Sizes.Set(Slot, TWireCodec<TMessage>::Size(Message, Sizes));
+}
+
+template <typename TMessage>
+uint8_t* WriteMessage(uint32_t Tag, const TMessage& Message, FWireSizes& Sizes, uint8_t* Out) {
+    Out = WriteVarint(Sizes.Next(), WriteVarint(Tag, Out));
+    return TWireCodec<TMessage>::Write(Message, Sizes, Out);
+}
+
+/** Repeated scalars in one length-delimited run, the proto3 default. */
+template <typename TArray>
+size_t PackedSize(size_t TagSize, const TArray& Values, FWireSizes& Sizes) {
+    size_t Length = 0;
+    for (const auto& Value : Values) Length += ValueSize(Value);
+    return TagSize + Sizes.Add(Length);
+}
+
+template <typename TArray>
+uint8_t* WritePacked(uint32_t Tag, const TArray& Values, FWireSizes& Sizes, uint8_t* Out) {
+    Out = WriteVarint(Sizes.Next(), WriteVarint(Tag, Out));
+    for (const auto& Value : Values) Out = WriteValue(Value, Out);
+    return Out;
+}
+
+}
+
+inline size_t FWireSizes::Set(size_t Slot, size_t Length) {
+    Sizes[Slot] = static_cast<uint32_t>(Length);
+    return Wire::VarintSize(Length) + Length;
+}
+
+/**
+ * Bounds-checked cursor over a serialized message. Any malformed input sets the error flag and
+ * makes every later read fail, so generated readers only have to check the result of each call.
+ */
+class FWireReader {
+public:
+    FWireReader() = default;
+    FWireReader(const uint8_t* InBegin, const uint8_t* InEnd) : Cursor(InBegin), End(InEnd) {}
+
+    /** Next field, or false at the end of the message or on malformed input. */
+    bool ReadTag(uint32_t& OutField, uint32_t& OutWireType) {
+        if (Cursor == End) return false;
+        uint64_t Tag;
+        if (!ReadVarint(Tag) || (Tag >> 3) == 0 || Tag > UINT32_MAX) return Fail();
+        OutField = static_cast<uint32_t>(Tag >> 3);
+        OutWireType = static_cast<uint32_t>(Tag & 7);
+        return true;
+    }
+
+    bool ReadVarint(uint64_t& Out) {
+        Out = 0;
+        for (int32_t Shift = 0; Shift < 64; Shift += 7) {
+            if (Cursor == End) return Fail();
+            const uint8_t Byte = *Cursor++;
+            Out |= static_cast<uint64_t>(Byte & 0x7F) << Shift;
+            if (!(Byte & 0x80)) return true;
+        }
+        return Fail();
+    }
+
+    bool ReadFixed32(uint32_t& Out) {
+        if (End - Cursor < 4) return Fail();
+        Out = 0;
+        for (int32_t i = 0; i < 4; i++) Out |= static_cast<uint32_t>(*Cursor++) << (8 * i);
+        return true;
+    }
+
+    bool ReadFixed64(uint64_t& Out) {
+        if (End - Cursor < 8) return Fail();
+        Out = 0;
+        for (int32_t i = 0; i < 8; i++) Out |= static_cast<uint64_t>(*Cursor++) << (8 * i);
+        return true;
+    }
+
+    /** A length-delimited field's bytes, which stay in the buffer being read. */
+    bool ReadBytes(uint32_t WireType, const uint8_t*& OutData, size_t& OutSize) {
+        uint64_t Length;
+        if (WireType != Wire::LengthDelimited || !ReadVarint(Length) || Length > static_cast<uint64_t>(End - Cursor)) return Fail();
+        OutData = Cursor;
+        OutSize = static_cast<size_t>(Length);
+        Cursor += Length;
+        return true;
+    }
+
+    /** A reader over a nested message. Its errors are its own; check the result of reading it. */
+    bool ReadMessage(uint32_t WireType, FWireReader& OutReader) {
+        const uint8_t* Data;
+        size_t Size;
+        if (!ReadBytes(WireType, Data, Size)) return false;
+        OutReader = FWireReader(Data, Data + Size);
+        return true;
+    }
+
+    /** A nested message, merged into Out by its TWireCodec. */
+    template <typename TMessage>
+    bool ReadStruct(uint32_t WireType, TMessage& Out) {
+        FWireReader Nested;
+        return ReadMessage(WireType, Nested) && TWireCodec<TMessage>::Read(Nested, Out);
+    }
+
+    template <typename TValue>
+    bool ReadValue(uint32_t WireType, TValue& Out) {
+        if (WireType != Wire::GetWireType<TValue>()) return Fail();
+        if constexpr (std::is_same_v<TValue, double>) {
+            uint64_t Bits;
+            if (!ReadFixed64(Bits)) return false;
+            std::memcpy(&Out, &Bits, sizeof(Out));
+        } else if constexpr (std::is_same_v<TValue, float>) {
+            uint32_t Bits;
+            if (!ReadFixed32(Bits)) return false;
+            std::memcpy(&Out, &Bits, sizeof(Out));
+        } else {
+            uint64_t Value;
+            if (!ReadVarint(Value)) return false;
+            if constexpr (std::is_same_v<TValue, bool>) Out = Value != 0;
+            else if constexpr (std::is_enum_v<TValue>) Out = static_cast<TValue>(static_cast<int32_t>(Value));
+            else Out = static_cast<TValue>(Value);
+        }
+        return true;
+    }
+
+    /** One element of a repeated scalar, or a whole packed run of them. Parsers must accept both. */
+    template <typename TArray>
+    bool ReadRepeated(uint32_t WireType, TArray& Out) {
+        using TValue = std::decay_t<decltype(*Out.GetData())>;
+        if (WireType != Wire::LengthDelimited) {
+            TValue Value{};
+            if (!ReadValue(WireType, Value)) return false;
+            Out.Add(Value);
+            return true;
+        }
+        FWireReader Packed;
+        if (!ReadMessage(WireType, Packed)) return false;
+        while (Packed.Cursor != Packed.End) {
+            TValue Value{};
+            if (!Packed.ReadValue(Wire::GetWireType<TValue>(), Value)) return Fail();
+            Out.Add(Value);
+        }
+        return true;
+    }
+
+    /** Steps over a field the struct has no member for, as protobuf would keep it as unknown. */
+    bool Skip(uint32_t WireType) {
+        uint64_t Ignored;
+        uint32_t Ignored32;
+        const uint8_t* Data;
+        size_t Size;
+        switch (WireType) {
+        case Wire::Varint: return ReadVarint(Ignored);
+        case Wire::Fixed64: return ReadFixed64(Ignored);
+        case Wire::LengthDelimited: return ReadBytes(WireType, Data, Size);
+        case Wire::Fixed32: return ReadFixed32(Ignored32);
+        default: return Fail();
+        }
+    }
+
+    /** True when the whole message was read without errors. */
+    [[nodiscard]] bool IsComplete() const { return !bError && Cursor == End; }
+
+private:
+    bool Fail() {
+        bError = true;
+        Cursor = End;
+        return false;
+    }
+
+    const uint8_t* Cursor = nullptr;
+    const uint8_t* End = nullptr;
+    bool bError = false;
+};
+
+/**
+ * grpc::SerializationTraits for USTRUCTs that have a TWireCodec, which the generated
+ * <File>Serialization.h installs. Calls made with USTRUCT types then go to and from the wire
+ * with no protobuf message in between. Sends serialize into an exact-size slice from a
+ * per-thread FSerializationSlab; received buffers of more than one slice are flattened once.
+ */
+template <typename T>
+class TWireSerializationTraits {
+public:
+    static grpc::Status Serialize(const T& Message, grpc::ByteBuffer* Buffer, bool* bOwnBuffer) {
+        thread_local FWireSizes Sizes;
+        thread_local FSerializationSlab Slab;
+        Sizes.Reset();
+        const size_t Size = TWireCodec<T>::Size(Message, Sizes);
+        grpc::Slice Slice = Slab.Write(Size, [&Message](uint8_t* Data) { TWireCodec<T>::Write(Message, Sizes, Data); });
+        grpc::ByteBuffer Serialized(&Slice, 1);
+        Buffer->Swap(&Serialized);
+        *bOwnBuffer = true;
+        return grpc::Status::OK;
+    }
+
+    static grpc::Status Deserialize(grpc::ByteBuffer* Buffer, T* Message) {
+        grpc::Slice Flat;
+        if (!Buffer->TrySingleSlice(&Flat).ok() && !Buffer->DumpToSingleSlice(&Flat).ok()) {
+            return grpc::Status(grpc::StatusCode::INTERNAL, "No payload");
+        }
+        Buffer->Clear();
+        *Message = T();
+        FWireReader Reader(Flat.begin(), Flat.end());
+        if (!TWireCodec<T>::Read(Reader, *Message)) {
+            return grpc::Status(grpc::StatusCode::INTERNAL, "Failed to parse message");
+        }
+        return grpc::Status::OK;
+    }
+
+    static uint64_t RecvSize(const void* Message) {
+        thread_local FWireSizes Sizes;
+        Sizes.Reset();
+        return TWireCodec<T>::Size(*static_cast<const T*>(Message), Sizes);
+    }
+
+    static void RecvSerialize(const void* Message, std::string& Out) {
+        thread_local FWireSizes Sizes;
+        Sizes.Reset();
+        Out.resize(TWireCodec<T>::Size(*static_cast<const T*>(Message), Sizes));
+        TWireCodec<T>::Write(*static_cast<const T*>(Message), Sizes, reinterpret_cast<uint8_t*>(Out.data()));
+    }
+
+    /** For the FScopedRecvCodec around calls that receive a T. */
+    static constexpr FRecvCodec RecvCodec{&RecvSize, &RecvSerialize};
+};
+
+}
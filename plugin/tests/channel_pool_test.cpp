@@ -0,0 +1,62 @@
+#include <chrono>
+#include <cstdio>
+#include <future>
+#include <grpcpp/generic/generic_stub.h>
+#include <grpcpp/grpcpp.h>
+#include "UnrealGrpc/GrpcChannelPool.h"
+
+static int Failures = 0;
+
+#define EXPECT(Condition) \
+    do { \
+        if (!(Condition)) { \
+            std::fprintf(stderr, "%s:%d: expected %s\n", __FILE__, __LINE__, #Condition); \
+            Failures++; \
+        } \
+    } while (0)
+
+//an empty channel list must still give a usable pool whose calls fail, not a crash on first use
+static void TestEmptyChannelList() {
+    UnrealGrpc::FChannelPool Pool(std::vector<std::shared_ptr<grpc::Channel>>{});
+    EXPECT(Pool.Num() == 1);
+    UnrealGrpc::FChannelPool::FLease Lease = Pool.Acquire();
+    EXPECT(Lease.IsValid());
+    const std::shared_ptr<grpc::Channel>& Channel = Pool.GetChannel(Lease.GetIndex());
+    EXPECT(Channel != nullptr);
+    if (!Channel) return;
+
+    grpc::GenericStub Stub(Channel);
+    grpc::ClientContext Context;
+    Context.set_deadline(std::chrono::system_clock::now() + std::chrono::seconds(10));
+    grpc::Slice Payload("");
+    grpc::ByteBuffer Request(&Payload, 1);
+    grpc::ByteBuffer Response;
+    std::promise<grpc::Status> Done;
+    Stub.UnaryCall(&Context, "/unreal.Test/Call", grpc::StubOptions(), &Request, &Response,
+        [&Done](grpc::Status Status) { Done.set_value(std::move(Status)); });
+    const grpc::Status Status = Done.get_future().get();
+    EXPECT(!Status.ok());
+    //failed up front rather than waiting out the deadline
+    EXPECT(Status.error_code() != grpc::StatusCode::DEADLINE_EXCEEDED);
+}
+
+static void TestWrappedChannels() {
+    std::vector<std::shared_ptr<grpc::Channel>> Channels;
+    for (int i = 0; i < 3; i++) Channels.push_back(grpc::CreateChannel("127.0.0.1:1", grpc::InsecureChannelCredentials()));
+    UnrealGrpc::FChannelPool Pool(Channels);
+    EXPECT(Pool.Num() == 3);
+    EXPECT(!Pool.OwnsConnections());
+    //held leases push new ones onto the idle channels
+    UnrealGrpc::FChannelPool::FLease A = Pool.Acquire();
+    UnrealGrpc::FChannelPool::FLease B = Pool.Acquire();
+    UnrealGrpc::FChannelPool::FLease C = Pool.Acquire();
+    EXPECT(A.GetIndex() != B.GetIndex() && B.GetIndex() != C.GetIndex() && A.GetIndex() != C.GetIndex());
+    for (int i = 0; i < 3; i++) EXPECT(Pool.GetChannel(i) == Channels[i]);
+}
+
+int main() {
+    TestEmptyChannelList();
+    TestWrappedChannels();
+    if (Failures) std::fprintf(stderr, "%d failed\n", Failures);
+    return Failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,69 @@
+# Runs the plugin on plain_struct_test.proto with no generator options, so the check doesn't depend on
+# loopback=true, and asserts on the headers it writes.
+# cmake -DPROTOC=<protoc> -DPLUGIN=<protoc-gen-unreal> -DPROTO_DIR=<dir> -DOPTIONS_DIR=<dir> -DOUT_DIR=<dir> -P check_plain_struct.cmake
+
+file(REMOVE_RECURSE "${OUT_DIR}")
+file(MAKE_DIRECTORY "${OUT_DIR}")
+
+function(run_plugin proto out_var err_var)
+    execute_process(
+        COMMAND "${PROTOC}" "--plugin=protoc-gen-unreal=${PLUGIN}" "--unreal_out=${OUT_DIR}"
+            -I "${PROTO_DIR}" -I "${OPTIONS_DIR}" "${proto}"
+        RESULT_VARIABLE result
+        ERROR_VARIABLE error
+    )
+    set(${out_var} "${result}" PARENT_SCOPE)
+    set(${err_var} "${error}" PARENT_SCOPE)
+endfunction()
+
+function(expect_contains file text)
+    file(READ "${OUT_DIR}/${file}" content)
+    string(FIND "${content}" "${text}" found)
+    if(found EQUAL -1)
+        message(FATAL_ERROR "${file} should contain '${text}'")
+    endif()
+endfunction()
+
+function(expect_missing file text)
+    file(READ "${OUT_DIR}/${file}" content)
+    string(FIND "${content}" "${text}" found)
+    if(NOT found EQUAL -1)
+        message(FATAL_ERROR "${file} should not contain '${text}'")
+    endif()
+endfunction()
+
+run_plugin(plain_struct_test.proto result error)
+if(NOT result EQUAL 0)
+    message(FATAL_ERROR "protoc failed on plain_struct_test.proto: ${error}")
+endif()
+
+# plain messages are invisible to UHT
+foreach(header FTick.h FTickBatch.h)
+    foreach(marker USTRUCT UPROPERTY GENERATED_BODY .generated.h TStructOpsTypeTraits)
+        expect_missing(${header} ${marker})
+    endforeach()
+endforeach()
+expect_contains(FTick.h "struct FTick {")
+expect_contains(FTick.h "TArray<float> Positions;")
+expect_contains(FTick.h "FString Note;")
+expect_contains(FTick.h "friend uint32 GetTypeHash(const FTick& In)")
+expect_contains(FTickBatch.h "#include \"FTick.h\"")
+expect_contains(FTickBatch.h "TArray<FTick> Ticks;")
+
+# reflected messages next to them are untouched
+expect_contains(FProfile.h "USTRUCT(BlueprintType)")
+expect_contains(FProfile.h "GENERATED_BODY()")
+expect_contains(FProfile.h "#include \"FProfile.generated.h\"")
+
+# plain structs convert like any other message
+expect_contains(PlainStructTestConverter.h "static FTick Convert(const ::unreal_test::Tick& In);")
+expect_contains(PlainStructTestConverter.h "static void ToProto(const FTick& In, ::unreal_test::Tick& Out);")
+
+run_plugin(plain_struct_rejected.proto result error)
+if(result EQUAL 0)
+    message(FATAL_ERROR "a reflected message holding a plain struct should be rejected")
+endif()
+string(FIND "${error}" "cannot hold plain struct unreal_test.Tick" found)
+if(found EQUAL -1)
+    message(FATAL_ERROR "unexpected error for plain_struct_rejected.proto: ${error}")
+endif()